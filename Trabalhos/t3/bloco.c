@@ -1,6 +1,13 @@
 #include "bloco.h"
+#include "processo.h"
 #include <stdbool.h>
 #include <stdlib.h>
+#include <assert.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define TEM_SIMD_X86
+#include <immintrin.h>
+#endif
 
 // rastreador de memoria física, cada bloco indica se está ocupado 
 // ou livre, e quem esta ocupando
@@ -13,17 +20,453 @@ bloco_t* cria_bloco(int tamanho){
     for(int i = 0; i < tamanho; i++){
         if(i < BLOCOS_RESERVADOS){ // reservando os dois primeiros blocos para o SO
             bloco[i].ocupado = true;
-            bloco[i].pid = 0; // bloco reservado para o SO (pid 0)
-            bloco[i].pg = -1;
             bloco[i].ciclos = 0;
-            bloco[i].acesso = 0;
         } else{
             bloco[i].ocupado = false;
-            bloco[i].pid = -1; // -1 indica livre
-            bloco[i].pg = -1;
             bloco[i].ciclos = 0;
-            bloco[i].acesso = 0;
         }
     }
     return bloco;
-}
\ No newline at end of file
+}
+
+// mapa de bits dos quadros livres
+// 'dica' é a primeira palavra do mapa que pode ter um quadro livre: as
+//   anteriores estão todas ocupadas. Como a busca sempre começa nela, achar o
+//   primeiro livre não precisa varrer os quadros ocupados do início da memória
+#define QUADROS_POR_PALAVRA 64
+struct quadros_livres_t {
+    int n_quadros;
+    int n_livres;
+    int n_palavras;
+    int dica;
+    uint64_t *livres;
+};
+
+quadros_livres_t* quadros_livres_cria(int n_quadros){
+    quadros_livres_t *self = malloc(sizeof(*self));
+    assert(self != NULL);
+    self->n_quadros = n_quadros;
+    self->n_palavras = (n_quadros + QUADROS_POR_PALAVRA - 1) / QUADROS_POR_PALAVRA;
+    self->livres = calloc(self->n_palavras > 0 ? self->n_palavras : 1, sizeof(uint64_t));
+    assert(self->livres != NULL);
+    self->n_livres = 0;
+    self->dica = 0;
+    // reservados para o SO começam ocupados, como em cria_bloco
+    for (int q = BLOCOS_RESERVADOS; q < n_quadros; q++){
+        quadros_livres_libera(self, q);
+    }
+    return self;
+}
+
+void quadros_livres_destroi(quadros_livres_t *self){
+    if (self == NULL) return;
+    free(self->livres);
+    free(self);
+}
+
+int quadros_livres_primeiro(quadros_livres_t *self){
+    if (self->n_livres == 0) return -1;
+    // avança a dica sobre as palavras sem quadro livre
+    while (self->dica < self->n_palavras && self->livres[self->dica] == 0){
+        self->dica++;
+    }
+    assert(self->dica < self->n_palavras);
+    uint64_t palavra = self->livres[self->dica];
+    return self->dica * QUADROS_POR_PALAVRA + __builtin_ctzll(palavra);
+}
+
+int quadros_livres_num(quadros_livres_t *self){
+    return self->n_livres;
+}
+
+void quadros_livres_ocupa(quadros_livres_t *self, int quadro){
+    if (quadro < 0 || quadro >= self->n_quadros) return;
+    uint64_t bit = (uint64_t)1 << (quadro % QUADROS_POR_PALAVRA);
+    uint64_t *palavra = &self->livres[quadro / QUADROS_POR_PALAVRA];
+    if (*palavra & bit){
+        *palavra &= ~bit;
+        self->n_livres--;
+    }
+}
+
+void quadros_livres_libera(quadros_livres_t *self, int quadro){
+    if (quadro < 0 || quadro >= self->n_quadros) return;
+    uint64_t bit = (uint64_t)1 << (quadro % QUADROS_POR_PALAVRA);
+    uint64_t *palavra = &self->livres[quadro / QUADROS_POR_PALAVRA];
+    if (!(*palavra & bit)){
+        *palavra |= bit;
+        self->n_livres++;
+        if (quadro / QUADROS_POR_PALAVRA < self->dica){
+            self->dica = quadro / QUADROS_POR_PALAVRA;
+        }
+    }
+}
+
+// mapa de páginas livres do disco
+#define PAGINAS_POR_PALAVRA 64
+struct mapa_disco_t {
+    int n_paginas;
+    int n_ocupadas;
+    int max_ocupadas;
+    int n_falhas;
+    uint64_t *livres;
+};
+
+mapa_disco_t* mapa_disco_cria(int n_paginas){
+    mapa_disco_t *self = malloc(sizeof(*self));
+    assert(self != NULL);
+    int n_palavras = (n_paginas + PAGINAS_POR_PALAVRA - 1) / PAGINAS_POR_PALAVRA;
+    self->livres = calloc(n_palavras > 0 ? n_palavras : 1, sizeof(uint64_t));
+    assert(self->livres != NULL);
+    self->n_paginas = n_paginas;
+    self->n_ocupadas = n_paginas;
+    self->max_ocupadas = 0;
+    self->n_falhas = 0;
+    mapa_disco_libera(self, 0, n_paginas);
+    return self;
+}
+
+void mapa_disco_destroi(mapa_disco_t *self){
+    if (self == NULL) return;
+    free(self->livres);
+    free(self);
+}
+
+static inline bool mapa_disco_livre(mapa_disco_t *self, int pagina){
+    return (self->livres[pagina / PAGINAS_POR_PALAVRA] >> (pagina % PAGINAS_POR_PALAVRA)) & 1;
+}
+
+int mapa_disco_aloca(mapa_disco_t *self, int n){
+    if (n <= 0) return -1;
+    // procura o primeiro trecho de n bits ligados; palavras sem nenhum bit
+    //   livre, e as com todos livres, são tratadas de uma vez
+    int inicio = 0;
+    int tam = 0;
+    int pagina = 0;
+    while (pagina < self->n_paginas && tam < n){
+        uint64_t palavra = self->livres[pagina / PAGINAS_POR_PALAVRA];
+        int desloc = pagina % PAGINAS_POR_PALAVRA;
+        uint64_t resto = palavra >> desloc;
+        if (desloc == 0 && palavra == ~(uint64_t)0){
+            if (tam == 0) inicio = pagina;
+            tam += PAGINAS_POR_PALAVRA;
+            pagina += PAGINAS_POR_PALAVRA;
+        } else if (resto == 0){
+            tam = 0;
+            pagina += PAGINAS_POR_PALAVRA - desloc;
+        } else if (resto & 1){
+            if (tam == 0) inicio = pagina;
+            tam++;
+            pagina++;
+        } else {
+            tam = 0;
+            pagina += __builtin_ctzll(resto);
+        }
+    }
+    if (tam < n){
+        self->n_falhas++;
+        return -1;
+    }
+    for (int p = inicio; p < inicio + n; p++){
+        self->livres[p / PAGINAS_POR_PALAVRA] &= ~((uint64_t)1 << (p % PAGINAS_POR_PALAVRA));
+    }
+    self->n_ocupadas += n;
+    if (self->n_ocupadas > self->max_ocupadas) self->max_ocupadas = self->n_ocupadas;
+    return inicio;
+}
+
+void mapa_disco_libera(mapa_disco_t *self, int pagina, int n){
+    for (int p = pagina; p < pagina + n && p < self->n_paginas; p++){
+        if (p < 0 || mapa_disco_livre(self, p)) continue;
+        self->livres[p / PAGINAS_POR_PALAVRA] |= (uint64_t)1 << (p % PAGINAS_POR_PALAVRA);
+        self->n_ocupadas--;
+    }
+}
+
+int mapa_disco_num_paginas(mapa_disco_t *self){
+    return self->n_paginas;
+}
+
+int mapa_disco_num_ocupadas(mapa_disco_t *self){
+    return self->n_ocupadas;
+}
+
+int mapa_disco_max_ocupadas(mapa_disco_t *self){
+    return self->max_ocupadas;
+}
+
+int mapa_disco_num_falhas(mapa_disco_t *self){
+    return self->n_falhas;
+}
+
+void mapa_disco_trechos_livres(mapa_disco_t *self, int *n_trechos, int *maior){
+    *n_trechos = 0;
+    *maior = 0;
+    int tam = 0;
+    for (int p = 0; p < self->n_paginas; p++){
+        if (mapa_disco_livre(self, p)){
+            if (tam == 0) (*n_trechos)++;
+            tam++;
+            if (tam > *maior) *maior = tam;
+        } else {
+            tam = 0;
+        }
+    }
+}
+
+// dono e idade dos quadros
+// o envelhecimento e a busca da menor idade têm três versões: AVX2 (8 quadros
+//   por vez), SSE2 (4 por vez) e escalar; todas dão o mesmo resultado.
+//   A AVX2 é escolhida em tempo de execução, se a CPU tiver; SSE2 é garantido
+//   em x86-64. Os vetores têm espaço para um vetor AVX2 a mais, para que os
+//   laços vetoriais não precisem de tratamento especial no final.
+#define QUADROS_POR_VETOR 8
+#define IDADE_MSB (1u << 31)
+
+#ifdef TEM_SIMD_X86
+static bool tem_avx2 = false;
+#endif
+
+donos_quadros_t* donos_quadros_cria(int n_quadros){
+    donos_quadros_t *self = malloc(sizeof(*self));
+    assert(self != NULL);
+    int n_alocados = n_quadros + QUADROS_POR_VETOR;
+    int n_palavras = (n_alocados + QUADROS_POR_PALAVRA - 1) / QUADROS_POR_PALAVRA;
+    self->n_quadros = n_quadros;
+    self->pid = malloc(n_alocados * sizeof(*self->pid));
+    self->pg = malloc(n_alocados * sizeof(*self->pg));
+    self->dono = calloc(n_alocados, sizeof(*self->dono));
+    self->imagem = calloc(n_alocados, sizeof(*self->imagem));
+    self->copia = calloc(n_alocados, sizeof(*self->copia));
+    self->prox = malloc(n_alocados * sizeof(*self->prox));
+    self->ant = malloc(n_alocados * sizeof(*self->ant));
+    self->idade = calloc(n_alocados, sizeof(*self->idade));
+    self->acessados = calloc(n_palavras, sizeof(*self->acessados));
+    assert(self->pid != NULL && self->pg != NULL && self->dono != NULL);
+    assert(self->imagem != NULL && self->copia != NULL);
+    assert(self->prox != NULL && self->ant != NULL);
+    assert(self->idade != NULL && self->acessados != NULL);
+    for (int i = 0; i < n_alocados; i++){
+        // pid 0 para os reservados do SO, -1 para livres
+        self->pid[i] = i < BLOCOS_RESERVADOS ? 0 : -1;
+        self->pg[i] = -1;
+        self->prox[i] = self->ant[i] = -1;
+    }
+#ifdef TEM_SIMD_X86
+    __builtin_cpu_init();
+    tem_avx2 = __builtin_cpu_supports("avx2");
+#endif
+    return self;
+}
+
+void donos_quadros_destroi(donos_quadros_t *self){
+    if (self == NULL) return;
+    free(self->pid);
+    free(self->pg);
+    free(self->dono);
+    free(self->imagem);
+    free(self->copia);
+    free(self->prox);
+    free(self->ant);
+    free(self->idade);
+    free(self->acessados);
+    free(self);
+}
+
+void donos_quadros_associa(donos_quadros_t *self, int quadro, pcb *proc, int pg){
+    if (self->dono[quadro] != proc) {
+        donos_quadros_desassocia(self, quadro);
+        // insere no início da lista do processo
+        self->dono[quadro] = proc;
+        self->ant[quadro] = -1;
+        self->prox[quadro] = proc->primeiro_quadro;
+        if (proc->primeiro_quadro >= 0) self->ant[proc->primeiro_quadro] = quadro;
+        proc->primeiro_quadro = quadro;
+        proc->num_quadros++;
+    }
+    self->pid[quadro] = proc->pid;
+    self->pg[quadro] = pg;
+}
+
+void donos_quadros_associa_imagem(donos_quadros_t *self, int quadro, struct imagem_t *img, int pg,
+                                  struct copia_t *copia){
+    if (self->imagem[quadro] != img) {
+        donos_quadros_desassocia(self, quadro);
+        self->imagem[quadro] = img;
+    }
+    self->copia[quadro] = copia;
+    self->pid[quadro] = PID_IMAGEM;
+    self->pg[quadro] = pg;
+}
+
+void donos_quadros_desassocia(donos_quadros_t *self, int quadro){
+    pcb *dono = self->dono[quadro];
+    if (dono != NULL) {
+        int ant = self->ant[quadro];
+        int prox = self->prox[quadro];
+        if (ant >= 0) self->prox[ant] = prox;
+        else dono->primeiro_quadro = prox;
+        if (prox >= 0) self->ant[prox] = ant;
+        dono->num_quadros--;
+        self->dono[quadro] = NULL;
+        self->prox[quadro] = self->ant[quadro] = -1;
+    }
+    self->imagem[quadro] = NULL;
+    self->copia[quadro] = NULL;
+    self->pid[quadro] = 0;
+    self->pg[quadro] = -1;
+    self->idade[quadro] = 0;
+}
+
+// bits de acesso dos quadros q a q+n-1 (n <= 8, q múltiplo de n)
+static inline unsigned bits_acessados(donos_quadros_t *self, int q, int n){
+    uint64_t palavra = self->acessados[q / QUADROS_POR_PALAVRA];
+    return (palavra >> (q % QUADROS_POR_PALAVRA)) & ((1u << n) - 1);
+}
+
+#ifndef TEM_SIMD_X86
+static void envelhece_escalar(donos_quadros_t *self, int pid){
+    for (int q = 0; q < self->n_quadros; q++){
+        if (self->pid[q] != pid && self->pid[q] != PID_IMAGEM) continue;
+        uint32_t msb = bits_acessados(self, q, 1) ? IDADE_MSB : 0;
+        self->idade[q] = (self->idade[q] >> 1) | msb;
+    }
+}
+
+static int menor_idade_escalar(donos_quadros_t *self){
+    int escolhido = -1;
+    for (int q = 0; q < self->n_quadros; q++){
+        if (self->pid[q] <= 0) continue;
+        if (escolhido < 0 || self->idade[q] < self->idade[escolhido]){
+            escolhido = q;
+        }
+    }
+    return escolhido;
+}
+
+#else
+// lanes de 'acessado' com todos os bits ligados se o bit correspondente de
+//   'bits' está ligado
+static inline __m128i expande_bits_sse2(unsigned bits){
+    const __m128i pesos = _mm_setr_epi32(1, 2, 4, 8);
+    __m128i b = _mm_and_si128(_mm_set1_epi32(bits), pesos);
+    return _mm_cmpeq_epi32(b, pesos);
+}
+
+static void envelhece_sse2(donos_quadros_t *self, int pid){
+    const __m128i alvo = _mm_set1_epi32(pid);
+    const __m128i imagem = _mm_set1_epi32(PID_IMAGEM);
+    const __m128i msb = _mm_set1_epi32(IDADE_MSB);
+    for (int q = 0; q < self->n_quadros; q += 4){
+        __m128i pids = _mm_loadu_si128((__m128i *)&self->pid[q]);
+        __m128i dono = _mm_or_si128(_mm_cmpeq_epi32(pids, alvo), _mm_cmpeq_epi32(pids, imagem));
+        if (_mm_movemask_epi8(dono) == 0) continue;
+        __m128i idade = _mm_loadu_si128((__m128i *)&self->idade[q]);
+        __m128i acessado = expande_bits_sse2(bits_acessados(self, q, 4));
+        __m128i nova = _mm_or_si128(_mm_srli_epi32(idade, 1), _mm_and_si128(acessado, msb));
+        idade = _mm_or_si128(_mm_and_si128(dono, nova), _mm_andnot_si128(dono, idade));
+        _mm_storeu_si128((__m128i *)&self->idade[q], idade);
+    }
+}
+
+static int menor_idade_sse2(donos_quadros_t *self){
+    // SSE2 não compara sem sinal; trocar o bit de sinal converte a comparação
+    //   sem sinal na com sinal
+    const __m128i sinal = _mm_set1_epi32(IDADE_MSB);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i menor = _mm_set1_epi32(INT32_MAX); // UINT32_MAX com sinal trocado
+    __m128i algum = zero;
+    for (int q = 0; q < self->n_quadros; q += 4){
+        __m128i valido = _mm_cmpgt_epi32(_mm_loadu_si128((__m128i *)&self->pid[q]), zero);
+        __m128i idade = _mm_xor_si128(_mm_loadu_si128((__m128i *)&self->idade[q]), sinal);
+        __m128i menor_aqui = _mm_cmplt_epi32(idade, menor);
+        __m128i troca = _mm_and_si128(valido, menor_aqui);
+        menor = _mm_or_si128(_mm_and_si128(troca, idade), _mm_andnot_si128(troca, menor));
+        algum = _mm_or_si128(algum, valido);
+    }
+    if (_mm_movemask_epi8(algum) == 0) return -1;
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, menor);
+    int32_t m = lanes[0];
+    for (int i = 1; i < 4; i++) if (lanes[i] < m) m = lanes[i];
+    // segunda passada: o primeiro quadro válido com essa idade
+    const __m128i alvo = _mm_set1_epi32(m);
+    for (int q = 0; q < self->n_quadros; q += 4){
+        __m128i valido = _mm_cmpgt_epi32(_mm_loadu_si128((__m128i *)&self->pid[q]), zero);
+        __m128i idade = _mm_xor_si128(_mm_loadu_si128((__m128i *)&self->idade[q]), sinal);
+        __m128i igual = _mm_and_si128(valido, _mm_cmpeq_epi32(idade, alvo));
+        int mascara = _mm_movemask_ps(_mm_castsi128_ps(igual));
+        if (mascara != 0) return q + __builtin_ctz(mascara);
+    }
+    return -1;
+}
+
+__attribute__((target("avx2")))
+static void envelhece_avx2(donos_quadros_t *self, int pid){
+    const __m256i alvo = _mm256_set1_epi32(pid);
+    const __m256i imagem = _mm256_set1_epi32(PID_IMAGEM);
+    const __m256i msb = _mm256_set1_epi32(IDADE_MSB);
+    const __m256i pesos = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    for (int q = 0; q < self->n_quadros; q += 8){
+        __m256i pids = _mm256_loadu_si256((__m256i *)&self->pid[q]);
+        __m256i dono = _mm256_or_si256(_mm256_cmpeq_epi32(pids, alvo), _mm256_cmpeq_epi32(pids, imagem));
+        if (_mm256_testz_si256(dono, dono)) continue;
+        __m256i idade = _mm256_loadu_si256((__m256i *)&self->idade[q]);
+        __m256i b = _mm256_and_si256(_mm256_set1_epi32(bits_acessados(self, q, 8)), pesos);
+        __m256i acessado = _mm256_cmpeq_epi32(b, pesos);
+        __m256i nova = _mm256_or_si256(_mm256_srli_epi32(idade, 1), _mm256_and_si256(acessado, msb));
+        idade = _mm256_blendv_epi8(idade, nova, dono);
+        _mm256_storeu_si256((__m256i *)&self->idade[q], idade);
+    }
+}
+
+__attribute__((target("avx2")))
+static int menor_idade_avx2(donos_quadros_t *self){
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i maximo = _mm256_set1_epi32(-1);
+    __m256i menor = maximo;
+    __m256i algum = zero;
+    for (int q = 0; q < self->n_quadros; q += 8){
+        __m256i valido = _mm256_cmpgt_epi32(_mm256_loadu_si256((__m256i *)&self->pid[q]), zero);
+        __m256i idade = _mm256_loadu_si256((__m256i *)&self->idade[q]);
+        // inválidos contam como a maior idade possível
+        idade = _mm256_blendv_epi8(maximo, idade, valido);
+        menor = _mm256_min_epu32(menor, idade);
+        algum = _mm256_or_si256(algum, valido);
+    }
+    if (_mm256_testz_si256(algum, algum)) return -1;
+    uint32_t lanes[8];
+    _mm256_storeu_si256((__m256i *)lanes, menor);
+    uint32_t m = lanes[0];
+    for (int i = 1; i < 8; i++) if (lanes[i] < m) m = lanes[i];
+    const __m256i alvo = _mm256_set1_epi32(m);
+    for (int q = 0; q < self->n_quadros; q += 8){
+        __m256i valido = _mm256_cmpgt_epi32(_mm256_loadu_si256((__m256i *)&self->pid[q]), zero);
+        __m256i idade = _mm256_loadu_si256((__m256i *)&self->idade[q]);
+        __m256i igual = _mm256_and_si256(valido, _mm256_cmpeq_epi32(idade, alvo));
+        int mascara = _mm256_movemask_ps(_mm256_castsi256_ps(igual));
+        if (mascara != 0) return q + __builtin_ctz(mascara);
+    }
+    return -1;
+}
+#endif
+
+void donos_quadros_envelhece(donos_quadros_t *self, int pid){
+#ifdef TEM_SIMD_X86
+    if (tem_avx2) envelhece_avx2(self, pid);
+    else envelhece_sse2(self, pid);
+#else
+    envelhece_escalar(self, pid);
+#endif
+    int n_palavras = (self->n_quadros + QUADROS_POR_VETOR + QUADROS_POR_PALAVRA - 1) / QUADROS_POR_PALAVRA;
+    for (int i = 0; i < n_palavras; i++) self->acessados[i] = 0;
+}
+
+int donos_quadros_menor_idade(donos_quadros_t *self){
+#ifdef TEM_SIMD_X86
+    if (tem_avx2) return menor_idade_avx2(self);
+    return menor_idade_sse2(self);
+#else
+    return menor_idade_escalar(self);
+#endif
+}
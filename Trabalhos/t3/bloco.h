@@ -18,12 +18,104 @@
 //#define BLOCOS_RESERVADOS ((CPU_END_FIM_PROT +1) / TAM_PAGINA )//número de blocos reservados para o SO
 typedef struct bloco{
     bool ocupado;
-    int pid; //pid do processo que está usando este bloco
-    int pg; //
     int ciclos; //guardar momento em que a página entrou na memória
-    uint32_t acesso; // para algoritmo de substituição LRU
 
 } bloco_t;
 
 bloco_t* cria_bloco(int tamanho);
+
+// mapa dos quadros livres da memória física
+// um bit por quadro (ligado se o quadro está livre), 64 quadros por palavra,
+//   e o número de quadros livres; os quadros reservados para o SO começam
+//   ocupados
+typedef struct quadros_livres_t quadros_livres_t;
+
+quadros_livres_t* quadros_livres_cria(int n_quadros);
+void quadros_livres_destroi(quadros_livres_t *self);
+// retorna o quadro livre de menor número, sem ocupá-lo (-1 se não tiver)
+int quadros_livres_primeiro(quadros_livres_t *self);
+// número de quadros livres
+int quadros_livres_num(quadros_livres_t *self);
+// marca o quadro como ocupado / livre
+void quadros_livres_ocupa(quadros_livres_t *self, int quadro);
+void quadros_livres_libera(quadros_livres_t *self, int quadro);
+
+// mapa das páginas livres da memória secundária (disco)
+// um bit por página (ligado se livre); cada processo ocupa um trecho contíguo
+//   de páginas com a imagem do seu programa, onde também são gravadas as suas
+//   páginas alteradas quando saem da memória principal
+// a alocação escolhe o primeiro trecho livre que caiba (first fit), o que
+//   tende a manter os trechos livres grandes no fim do disco
+typedef struct mapa_disco_t mapa_disco_t;
+
+mapa_disco_t* mapa_disco_cria(int n_paginas);
+void mapa_disco_destroi(mapa_disco_t *self);
+// aloca n páginas contíguas; retorna a primeira (-1 se não tiver trecho livre
+//   com esse tamanho)
+int mapa_disco_aloca(mapa_disco_t *self, int n);
+// libera as n páginas a partir de 'pagina'
+void mapa_disco_libera(mapa_disco_t *self, int pagina, int n);
+// número de páginas do disco, de páginas em uso, e máximo de páginas que
+//   estiveram em uso ao mesmo tempo
+int mapa_disco_num_paginas(mapa_disco_t *self);
+int mapa_disco_num_ocupadas(mapa_disco_t *self);
+int mapa_disco_max_ocupadas(mapa_disco_t *self);
+// número de alocações que falharam por falta de um trecho livre
+int mapa_disco_num_falhas(mapa_disco_t *self);
+// número de trechos livres e tamanho do maior deles
+void mapa_disco_trechos_livres(mapa_disco_t *self, int *n_trechos, int *maior);
+
+// dono e idade de cada quadro
+// é uma tabela de páginas invertida: para cada quadro, o processo (pid e
+//   descritor) e a página que ele contém; assim, quem escolhe um quadro para
+//   substituir acha a página que sai sem procurar o processo
+// os quadros de cada processo formam uma lista duplamente encadeada (pelos
+//   vetores prox e ant, começando em pcb->primeiro_quadro), para que liberar
+//   a memória de um processo passe só pelos seus quadros
+// os vetores são contíguos, e não parte de bloco_t, porque o envelhecimento
+//   (LRU) passa por todos os quadros a cada interrupção de relógio; assim dá
+//   para tratar vários quadros por instrução (SSE2/AVX2, quando a CPU tem)
+// os bits de acesso dos quadros são recolhidos em um mapa de bits antes de
+//   envelhecer, em vez de consultar a tabela de páginas quadro a quadro
+// um quadro com uma página de uma imagem compartilhada (ver imagem.h) não é de
+//   nenhum processo: tem pid PID_IMAGEM e a imagem no lugar do descritor; se
+//   a página é uma cópia compartilhada por processos clonados, o quadro tem
+//   também a cópia
+#define PID_IMAGEM INT32_MAX
+struct pcb;
+struct imagem_t;
+struct copia_t;
+typedef struct donos_quadros_t {
+    int n_quadros;
+    int *pid;           // pid do processo que está usando o quadro (0 SO, -1 livre)
+    int *pg;            // página do processo que está no quadro (-1 se nenhuma)
+    struct pcb **dono;  // descritor do processo (NULL se não for de processo)
+    struct imagem_t **imagem; // imagem compartilhada (NULL se não for de imagem)
+    struct copia_t **copia;   // cópia compartilhada (NULL se for a página da imagem)
+    int *prox, *ant;    // lista de quadros do mesmo processo (-1 no fim)
+    uint32_t *idade;    // contador de envelhecimento, para o LRU
+    uint64_t *acessados; // mapa de bits dos quadros acessados, 64 por palavra
+} donos_quadros_t;
+
+donos_quadros_t* donos_quadros_cria(int n_quadros);
+void donos_quadros_destroi(donos_quadros_t *self);
+// o quadro passa a conter a página 'pg' do processo 'proc', e entra na
+//   lista de quadros dele; se era de outro processo, sai da lista desse
+void donos_quadros_associa(donos_quadros_t *self, int quadro, struct pcb *proc, int pg);
+// o quadro passa a conter a página 'pg' da imagem 'img', ou a cópia 'copia'
+//   dessa página (NULL se for a da imagem); se era de um processo, sai da
+//   lista dele
+void donos_quadros_associa_imagem(donos_quadros_t *self, int quadro, struct imagem_t *img, int pg,
+                                  struct copia_t *copia);
+// o quadro deixa de ser do seu processo (sai da lista dele) ou da sua imagem,
+//   fica com pid 0 e idade 0
+void donos_quadros_desassocia(donos_quadros_t *self, int quadro);
+// envelhece os quadros do processo 'pid' e os das imagens compartilhadas:
+//   desloca a idade para a direita e liga o bit mais significativo dos que
+//   estão no mapa de acessados
+// zera o mapa de acessados
+void donos_quadros_envelhece(donos_quadros_t *self, int pid);
+// retorna o quadro de processo (pid > 0) com a menor idade; o de menor número
+//   em caso de empate (-1 se não tiver nenhum)
+int donos_quadros_menor_idade(donos_quadros_t *self);
 #endif
\ No newline at end of file
@@ -16,6 +16,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <assert.h>
 
 
@@ -44,6 +47,12 @@
 // números de comandos para o controlador que podem ser guardados na console
 #define N_CMD_EXT 10
 
+// número de linhas digitadas que podem esperar para serem interpretadas
+#define N_LINHAS_DIGITADAS 4
+
+// intervalo inicial entre dois desenhos da tela (~30 quadros por segundo)
+#define PERIODO_QUADRO_MS 33
+
 
 // ---------------------------------------------------------------------
 // DECLARAÇÃO {{{1
@@ -58,6 +67,27 @@ struct console_t {
   char txt_entrada[N_COL+1];
   char fila_de_comandos_externos[N_CMD_EXT];
   FILE *arquivo_de_log;
+  // modo lote: sem tela, comandos lidos do roteiro
+  bool sem_tela;
+  FILE *roteiro;
+  relogio_t *relogio;
+  bool tem_linha_roteiro;        // linha_roteiro já foi lida e não interpretada
+  int quando_linha_roteiro;      // instante em que linha_roteiro deve ser interpretada
+  char linha_roteiro[N_COL+1];
+  FILE *arquivo_terminal[N_TERM];
+  // com tela: o desenho e a leitura do teclado são feitos por uma thread
+  //   própria, a cada periodo_quadro_ms, independente da execução das
+  //   instruções. Essa thread só acessa o que está abaixo e txt_status e
+  //   txt_console, com 'trava' fechada, e txt_entrada, que é só dela.
+  pthread_t thread_tela;
+  pthread_mutex_t trava;
+  atomic_bool terminar;           // pede o fim da thread da tela
+  atomic_bool quadro_pedido;      // a thread da tela quer uma cópia nova dos terminais
+  atomic_int periodo_quadro_ms;
+  atomic_int n_linhas_digitadas;
+  char linhas_digitadas[N_LINHAS_DIGITADAS][N_COL+1];
+  char copia_entrada_term[N_TERM][N_COL+1];
+  char copia_saida_term[N_TERM][N_COL+1];
 };
 
 
@@ -66,7 +96,30 @@ struct console_t {
 // ---------------------------------------------------------------------
 
 static console_t *console_global; // gambiarra para simplificar o uso de prints na console
-console_t *console_cria(void)
+
+static void *laco_da_tela(void *arg);
+
+// abre o roteiro e os arquivos de saída dos terminais, para o modo lote
+static void inicializa_modo_lote(console_t *self, char *roteiro)
+{
+  if (strcmp(roteiro, "-") == 0) {
+    self->roteiro = stdin;
+  } else {
+    self->roteiro = fopen(roteiro, "r");
+  }
+  if (self->roteiro == NULL) {
+    fprintf(stderr, "Erro na abertura do roteiro '%s'\n", roteiro);
+    exit(1);
+  }
+  for (int t = 0; t < N_TERM; t++) {
+    char nome[30];
+    sprintf(nome, "saida_do_terminal_%c", 'A' + t);
+    self->arquivo_terminal[t] = fopen(nome, "w");
+    terminal_define_arquivo_saida(self->term[t], self->arquivo_terminal[t]);
+  }
+}
+
+console_t *console_cria(char *roteiro)
 {
   console_t *self = malloc(sizeof(*self));
   assert(self != NULL);
@@ -89,26 +142,74 @@ console_t *console_cria(void)
   self->fila_de_comandos_externos[0] = '\0';
   self->arquivo_de_log = fopen("log_da_console", "w");
 
-  tela_init();
+  self->sem_tela = (roteiro != NULL);
+  self->roteiro = NULL;
+  self->relogio = NULL;
+  self->tem_linha_roteiro = false;
+  for (int t = 0; t < N_TERM; t++) {
+    self->arquivo_terminal[t] = NULL;
+  }
+
+  pthread_mutex_init(&self->trava, NULL);
+  atomic_init(&self->terminar, false);
+  atomic_init(&self->quadro_pedido, false);
+  atomic_init(&self->periodo_quadro_ms, PERIODO_QUADRO_MS);
+  atomic_init(&self->n_linhas_digitadas, 0);
+  for (int t = 0; t < N_TERM; t++) {
+    strcpy(self->copia_entrada_term[t], "");
+    strcpy(self->copia_saida_term[t], "");
+  }
+  strcpy(self->txt_status, "");
+
+  if (self->sem_tela) {
+    inicializa_modo_lote(self, roteiro);
+  } else {
+    tela_init();
+    int r = pthread_create(&self->thread_tela, NULL, laco_da_tela, self);
+    assert(r == 0);
+  }
 
   return self;
 }
 
+void console_define_relogio(console_t *self, relogio_t *relogio)
+{
+  self->relogio = relogio;
+}
+
+void console_redireciona_log(console_t *self, char *nome)
+{
+  if (self->arquivo_de_log != NULL) fclose(self->arquivo_de_log);
+  self->arquivo_de_log = fopen(nome, "w");
+}
+
+static void copia_terminais(console_t *self);
 static void console_desenha(console_t *self);
 
 void console_destroi(console_t *self)
 {
-  console_desenha(self);
   if (self->arquivo_de_log != NULL) fclose(self->arquivo_de_log);
-  tela_puts(COR_OCUPADO, "  digite ENTER para sair  ");
-  tela_atualiza();
-  while (tela_tecla() != '\n') {
-    ;
+  if (self->sem_tela) {
+    if (self->roteiro != NULL && self->roteiro != stdin) fclose(self->roteiro);
+  } else {
+    // acaba com a thread da tela; daqui pra frente, só esta mexe na tela
+    atomic_store(&self->terminar, true);
+    pthread_join(self->thread_tela, NULL);
+    copia_terminais(self);
+    console_desenha(self);
+    tela_puts(COR_OCUPADO, "  digite ENTER para sair  ");
+    tela_atualiza();
+    tela_espera(100);
+    while (tela_tecla() != '\n') {
+      ;
+    }
+    tela_fim();
   }
-  tela_fim();
+  pthread_mutex_destroy(&self->trava);
 
   for (int t = 0; t < N_TERM; t++) {
     terminal_destroi(self->term[t]);
+    if (self->arquivo_terminal[t] != NULL) fclose(self->arquivo_terminal[t]);
   }
   free(self);
   return;
@@ -192,10 +293,18 @@ static void insere_strings_na_console(console_t *self, char *s)
   insere_strings_na_console(self, f + 1);
 }
 
+bool console_precisa_de_status(console_t *self)
+{
+  // só vale a pena montar o status quando ele vai ser desenhado
+  return !self->sem_tela && atomic_load(&self->quadro_pedido);
+}
+
 void console_print_status(console_t *self, char *txt)
 {
+  pthread_mutex_lock(&self->trava);
   // imprime alinhado a esquerda ("-"), max N_COL chars ("*")
   sprintf(self->txt_status, "%-*s", N_COL, txt);
+  pthread_mutex_unlock(&self->trava);
 }
 
 int console_printf(char *formato, ...)
@@ -208,7 +317,9 @@ int console_printf(char *formato, ...)
   va_list arg;
   va_start(arg, formato);
   int r = vsnprintf(s, sizeof(s), formato, arg);
+  pthread_mutex_lock(&self->trava);
   insere_strings_na_console(self, s);
+  pthread_mutex_unlock(&self->trava);
   return r;
 }
 
@@ -236,19 +347,18 @@ static char remove_comando_externo(console_t *self)
   return cmd;
 }
 
-static void interpreta_linha_entrada(console_t *self)
+static void interpreta_linha_entrada(console_t *self, char *linha)
 {
   // interpreta uma linha digitada pelo operador
   // Comandos aceitos:
   // Etstr entra a string 'str' no terminal 't'  ex: eb30
   // Zt    esvazia a saída do terminal 't'  ex: za
-  // Dn    altera o tempo de espera do teclado  ex: d0  -> modo turbo
+  // Dn    altera o intervalo entre desenhos da tela, em ms  ex: d100
   // P     para a execução
   // 1     executa uma instrução
   // C     continua a execução
   // F     fim da simulação
 
-  char *linha = self->txt_entrada;
   console_printf("CMD: '%s'", linha);
   char cmd = toupper(linha[0]);
   int val;
@@ -261,7 +371,8 @@ static void interpreta_linha_entrada(console_t *self)
       break;
     case 'D':
       val = atoi(&linha[1]);
-      tela_espera(val);
+      if (val < 1) val = 1;
+      atomic_store(&self->periodo_quadro_ms, val);
       break;
     case 'P':
     case '1':
@@ -272,26 +383,106 @@ static void interpreta_linha_entrada(console_t *self)
     default:
       console_printf("Comando '%c' não reconhecido", cmd);
   }
+}
+
+// chamada pela thread da tela quando o operador tecla 'enter'
+// passa a linha digitada para ser interpretada pelo simulador
+static void entrega_linha_digitada(console_t *self)
+{
+  pthread_mutex_lock(&self->trava);
+  int n = atomic_load(&self->n_linhas_digitadas);
+  if (n < N_LINHAS_DIGITADAS) {
+    strcpy(self->linhas_digitadas[n], self->txt_entrada);
+    atomic_store(&self->n_linhas_digitadas, n + 1);
+  } // senão, o simulador tá muito atrasado; ignora a linha
+  pthread_mutex_unlock(&self->trava);
   strcpy(self->txt_entrada, "");
 }
 
-// lê e guarda um caractere do teclado; interpreta linha se for 'enter'
-static void verifica_entrada(console_t *self)
+// lê e guarda os caracteres disponíveis no teclado; entrega a linha se for
+//   'enter'
+// executada pela thread da tela
+static void le_teclado(console_t *self)
 {
-  char ch = tela_tecla();
+  char ch;
+  while ((ch = tela_tecla()) != 0) {
+    int l = strlen(self->txt_entrada);
+
+    if (ch == '\b' || ch == 127) {   // backspace ou del
+      if (l > 0) {
+        self->txt_entrada[l - 1] = '\0';
+      }
+    } else if (ch == '\n') {
+      entrega_linha_digitada(self);
+    } else if (ch >= ' ' && ch < 127 && l < N_COL) {
+      self->txt_entrada[l] = ch;
+      self->txt_entrada[l+1] = '\0';
+    } // senão, ignora o caractere digitado
+  }
+}
 
-  int l = strlen(self->txt_entrada);
+// interpreta a próxima linha entregue pela thread da tela, se houver
+static void verifica_linhas_digitadas(console_t *self)
+{
+  if (atomic_load(&self->n_linhas_digitadas) == 0) return;
+  char linha[N_COL+1];
+  pthread_mutex_lock(&self->trava);
+  int n = atomic_load(&self->n_linhas_digitadas);
+  strcpy(linha, self->linhas_digitadas[0]);
+  memmove(self->linhas_digitadas[0], self->linhas_digitadas[1],
+          (n - 1) * sizeof(self->linhas_digitadas[0]));
+  atomic_store(&self->n_linhas_digitadas, n - 1);
+  pthread_mutex_unlock(&self->trava);
+  interpreta_linha_entrada(self, linha);
+}
 
-  if (ch == '\b' || ch == 127) {   // backspace ou del
-    if (l > 0) {
-      self->txt_entrada[l - 1] = '\0';
+// lê a próxima linha útil do roteiro para linha_roteiro, se ainda não tiver
+// retorna false se o roteiro acabou
+static bool le_linha_do_roteiro(console_t *self)
+{
+  char linha[N_COL+1];
+  while (!self->tem_linha_roteiro) {
+    if (self->roteiro == NULL || fgets(linha, sizeof(linha), self->roteiro) == NULL) {
+      return false;
+    }
+    linha[strcspn(linha, "\r\n")] = '\0';
+    char *p = linha;
+    self->quando_linha_roteiro = 0;
+    if (*p == '@') {
+      int n;
+      if (sscanf(p + 1, "%d %n", &self->quando_linha_roteiro, &n) != 1) {
+        console_printf("Roteiro: tempo inválido em '%s'", linha);
+        continue;
+      }
+      p += 1 + n;
     }
-  } else if (ch == '\n') {
-    interpreta_linha_entrada(self);
-  } else if (ch >= ' ' && ch < 127 && l < N_COL) {
-    self->txt_entrada[l] = ch;
-    self->txt_entrada[l+1] = '\0';
-  } // senão, ignora o caractere digitado
+    if (*p == '\0' || *p == '#') continue;
+    strcpy(self->linha_roteiro, p);
+    self->tem_linha_roteiro = true;
+  }
+  return true;
+}
+
+// interpreta a próxima linha do roteiro, se já for a hora dela
+static void verifica_roteiro(console_t *self)
+{
+  if (!le_linha_do_roteiro(self)) return;
+  int agora = 0;
+  if (self->relogio != NULL) relogio_leitura(self->relogio, 0, &agora);
+  if (agora < self->quando_linha_roteiro) return;
+  self->tem_linha_roteiro = false;
+  interpreta_linha_entrada(self, self->linha_roteiro);
+}
+
+// interpreta a próxima linha de comando do operador, venha ela do teclado
+//   ou do roteiro
+static void verifica_entrada(console_t *self)
+{
+  if (self->sem_tela) {
+    verifica_roteiro(self);
+  } else {
+    verifica_linhas_digitadas(self);
+  }
 }
 
 char console_comando_externo(console_t *self)
@@ -313,15 +504,27 @@ static void desenha_linha_terminal(char *txt, int linha, int cor_txt, int cor_cu
   tela_puts(cor_cursor, " ");
 }
 
+// copia o estado dos terminais para a thread da tela desenhar
+// os terminais são alterados pela execução das instruções, a thread da tela
+//   só vê essa cópia
+static void copia_terminais(console_t *self)
+{
+  pthread_mutex_lock(&self->trava);
+  for (int t = 0; t < N_TERM; t++) {
+    strcpy(self->copia_entrada_term[t], terminal_txt_entrada(self->term[t]));
+    strcpy(self->copia_saida_term[t], terminal_txt_saida(self->term[t]));
+  }
+  pthread_mutex_unlock(&self->trava);
+}
+
 static void desenha_terminais(console_t *self)
 {
   for (int t = 0; t < N_TERM; t++) {
-    terminal_t *terminal = self->term[t];
     int cor_txt = self->cor_txt[t];
     int cor_cursor = self->cor_cursor[t];
     int linha = LINHA_TERM + t * 2;
-    desenha_linha_terminal(terminal_txt_entrada(terminal), linha, cor_txt, cor_cursor);
-    desenha_linha_terminal(terminal_txt_saida(terminal), linha+1, cor_txt, cor_cursor);
+    desenha_linha_terminal(self->copia_entrada_term[t], linha, cor_txt, cor_cursor);
+    desenha_linha_terminal(self->copia_saida_term[t], linha+1, cor_txt, cor_cursor);
   }
 }
 
@@ -355,25 +558,82 @@ static void desenha_entrada(console_t *self)
 
 static void console_desenha(console_t *self)
 {
+  pthread_mutex_lock(&self->trava);
   desenha_terminais(self);
   desenha_status(self);
   desenha_console(self);
   desenha_entrada(self);
+  pthread_mutex_unlock(&self->trava);
 
   // faz aparecer tudo que foi desenhado
   tela_atualiza();
 }
 
+// espera até o instante 'prox', e avança ele 'ms' milisegundos
+static void espera_proximo_quadro(struct timespec *prox, int ms)
+{
+  clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, prox, NULL);
+  prox->tv_nsec += ms * 1000000L;
+  while (prox->tv_nsec >= 1000000000L) {
+    prox->tv_nsec -= 1000000000L;
+    prox->tv_sec++;
+  }
+  // se atrasou mais de um quadro, não tenta recuperar o atraso
+  struct timespec agora;
+  clock_gettime(CLOCK_MONOTONIC, &agora);
+  if (agora.tv_sec > prox->tv_sec
+      || (agora.tv_sec == prox->tv_sec && agora.tv_nsec > prox->tv_nsec)) {
+    *prox = agora;
+  }
+}
+
+// laço da thread da tela: lê o teclado e redesenha a tela a cada quadro,
+//   usando a última cópia do estado feita pelo simulador
+static void *laco_da_tela(void *arg)
+{
+  console_t *self = arg;
+  struct timespec prox;
+  clock_gettime(CLOCK_MONOTONIC, &prox);
+  tela_espera(0); // a espera é entre quadros, não na leitura do teclado
+  while (!atomic_load(&self->terminar)) {
+    atomic_store(&self->quadro_pedido, true);
+    le_teclado(self);
+    console_desenha(self);
+    espera_proximo_quadro(&prox, atomic_load(&self->periodo_quadro_ms));
+  }
+  return NULL;
+}
+
 
 // ---------------------------------------------------------------------
 // TICTAC {{{1
 // ---------------------------------------------------------------------
 
+int console_tics_sem_evento(console_t *self, int max)
+{
+  for (int t = 0; t < N_TERM; t++) {
+    if (!terminal_ocioso(self->term[t])) return 1;
+  }
+  // com tela, as linhas chegam quando o operador digita; não tem como prever
+  if (!self->sem_tela) return max;
+  if (!le_linha_do_roteiro(self)) return max;
+  int agora = 0;
+  if (self->relogio != NULL) relogio_leitura(self->relogio, 0, &agora);
+  int n = self->quando_linha_roteiro - agora;
+  if (n < 1) return 1;
+  return n < max ? n : max;
+}
+
 void console_tictac(console_t *self)
 {
   verifica_entrada(self);
   atualiza_terminais(self);
-  console_desenha(self);
+  // o desenho é feito pela thread da tela; aqui só se entrega a ela uma
+  //   cópia do estado dos terminais, quando ela pede
+  if (atomic_load(&self->quadro_pedido)) {
+    copia_terminais(self);
+    atomic_store(&self->quadro_pedido, false);
+  }
 }
 
 // vim: foldmethod=marker
@@ -8,18 +8,44 @@
 
 #include <stdbool.h>
 #include "terminal.h"
+#include "relogio.h"
 
 typedef struct console_t console_t;
 
 // cria e inicializa a console
-console_t *console_cria(void);
+// se 'roteiro' for NULL, a console usa a tela (curses) e o teclado do
+//   operador
+// senão, a console executa sem tela (modo lote): as linhas de comando do
+//   operador são lidas do arquivo 'roteiro' ("-" para a entrada padrão), uma
+//   a cada chamada a console_tictac, e a saída de cada terminal é gravada no
+//   arquivo "saida_do_terminal_X" (X é 'A', 'B', etc)
+// uma linha do roteiro pode começar com "@n", para só ser interpretada quando
+//   o relógio chegar a 'n' instruções (ver console_define_relogio). Ex:
+//     C
+//     @1000 EB30
+//     @500000 F
+// linhas vazias ou iniciadas por '#' são ignoradas
+// o roteiro deve terminar com o comando 'F', senão a simulação não termina
+console_t *console_cria(char *roteiro);
 
 // destrói a console
 void console_destroi(console_t *self);
 
+// define o relógio usado para decidir quando interpretar as linhas "@n" do
+//   roteiro
+void console_define_relogio(console_t *self, relogio_t *relogio);
+
+// passa a gravar o registro do que é impresso na console no arquivo 'nome',
+//   no lugar de "log_da_console"
+void console_redireciona_log(console_t *self, char *nome);
+
 // imprime na área geral do console
 int console_printf(char *fmt, ...);
 
+// retorna true se a linha de status está sendo mostrada (se retornar false,
+//   não tem por que calcular o status a imprimir)
+bool console_precisa_de_status(console_t *self);
+
 // imprime na linha de status
 void console_print_status(console_t *self, char *txt);
 
@@ -40,4 +66,12 @@ terminal_t *console_terminal(console_t *self, char id_terminal);
 // esta função deve ser chamada periodicamente para que tela funcione
 void console_tictac(console_t *self);
 
+// retorna quantas unidades de tempo (no máximo 'max') podem passar sem que
+//   a console tenha algo a fazer: os terminais não estão sendo atualizados e
+//   não chega a hora da próxima linha do roteiro
+// retorna 1 se a console tem algo a fazer no próximo tictac
+// usado pelo controlador para avançar o tempo de uma vez quando a CPU está
+//   parada, sem alterar o que acontece na console
+int console_tics_sem_evento(console_t *self, int max);
+
 #endif // CONSOLE_H
@@ -8,8 +8,20 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <unistd.h>
 #include <assert.h>
 
+// tempo de espera a cada volta do laço quando a execução está parada
+#define ESPERA_PARADO_US 1000
+
+// máximo de tempo que o relógio avança de uma vez com a CPU parada, quando
+//   o timer está desligado
+#define MAX_AVANCO_CPU_PARADA 1000
+
+// máximo de instruções executadas em cada volta do laço (limita o tempo sem
+//   atender a console)
+#define MAX_INSTRUCOES_POR_VOLTA 1000
+
 struct controle_t {
   cpu_t *cpu;
   relogio_t *relogio;
@@ -20,6 +32,8 @@ struct controle_t {
 // funções auxiliares
 static void controle_processa_comandos_da_console(controle_t *self);
 static void controle_atualiza_estado_na_console(controle_t *self);
+static int controle_tics_ate_proximo_evento(controle_t *self, int max);
+static void controle_avanca_relogio(void *arg, int n);
 
 
 controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio)
@@ -44,11 +58,33 @@ void controle_laco(controle_t *self)
 {
   // executa uma instrução por vez até a console dizer que chega
   do {
-    if (self->estado == passo || self->estado == executando) {
+    if (self->estado == executando && cpu_parada(self->cpu)) {
+      // com a CPU parada nada acontece até o próximo evento (interrupção do
+      //   relógio ou algo na console) -- avança o relógio direto até ele
+      relogio_avanca(self->relogio,
+                     controle_tics_ate_proximo_evento(self, MAX_AVANCO_CPU_PARADA));
+
+      int tem_int;
+      relogio_leitura(self->relogio, 3, &tem_int);
+      if (tem_int != 0) {
+        cpu_interrompe(self->cpu, IRQ_RELOGIO);
+      }
+    } else if (self->estado == executando) {
+      // executa instruções em lote até o próximo evento; a CPU avança o
+      //   relógio pelas instruções executadas
+      int max = controle_tics_ate_proximo_evento(self, MAX_INSTRUCOES_POR_VOLTA);
+      cpu_executa_n(self->cpu, max, controle_avanca_relogio, self);
+
+      int tem_int;
+      relogio_leitura(self->relogio, 3, &tem_int);
+      if (tem_int != 0) {
+        cpu_interrompe(self->cpu, IRQ_RELOGIO);
+      }
+    } else if (self->estado == passo) {
       cpu_executa_1(self->cpu);
       relogio_tictac(self->relogio);
 
-      if (self->estado == passo) self->estado = parado;
+      self->estado = parado;
 
       // enquanto não tem controlador de interrupção, fala direto com o relógio
       // o dispositivo 3 do relógio contém 1 se o timer expirou
@@ -57,17 +93,44 @@ void controle_laco(controle_t *self)
       if (tem_int != 0) {
         cpu_interrompe(self->cpu, IRQ_RELOGIO);
       }
+    } else {
+      // sem nada a executar, não precisa girar o laço a toda
+      usleep(ESPERA_PARADO_US);
     }
-    console_tictac(self->console);
 
     controle_processa_comandos_da_console(self);
+    // o status é atualizado antes do tictac, que entrega à console o que
+    //   vai ser desenhado
     controle_atualiza_estado_na_console(self);
+    console_tictac(self->console);
   } while (self->estado != fim);
 
   console_printf("Fim da execução.");
 }
  
 
+// calcula quantas voltas do laço (no máximo 'max') podem ser feitas em uma
+//   só: até o timer gerar interrupção, sem passar do momento em que a console
+//   tem algo a fazer
+// se uma interrupção já está sendo pedida (e não foi aceita pela CPU), ela
+//   deve ser tentada de novo a cada instrução
+static int controle_tics_ate_proximo_evento(controle_t *self, int max)
+{
+  int tem_int;
+  relogio_leitura(self->relogio, 3, &tem_int);
+  if (tem_int != 0) return 1;
+  int n = relogio_tics_ate_interrupcao(self->relogio);
+  if (n <= 0 || n > max) n = max;
+  return console_tics_sem_evento(self->console, n);
+}
+
+// chamada pela CPU com o número de instruções executadas
+static void controle_avanca_relogio(void *arg, int n)
+{
+  controle_t *self = arg;
+  relogio_avanca(self->relogio, n);
+}
+
 static void controle_processa_comandos_da_console(controle_t *self)
 {
   char cmd = console_comando_externo(self->console);
@@ -89,6 +152,8 @@ static void controle_processa_comandos_da_console(controle_t *self)
 
 static void controle_atualiza_estado_na_console(controle_t *self)
 {
+  // sem tela não tem onde mostrar o status, economiza a formatação
+  if (!console_precisa_de_status(self->console)) return;
   char status[100];
   switch (self->estado) {
     case fim:        strcpy(status, "FIM    | "); break;
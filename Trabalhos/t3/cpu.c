@@ -22,6 +22,33 @@
 // DECLARAÇÃO {{{1
 // ---------------------------------------------------------------------
 
+// tipo das funções que executam cada instrução
+typedef void (*f_instrucao_t)(cpu_t *self);
+
+// número máximo de instruções fundidas a uma instrução do cache
+#define MAX_FUNDIDAS 4
+
+// uma instrução já decodificada, guardada no cache de instruções
+typedef struct {
+  // função que executa a instrução; NULL se a entrada não for válida
+  f_instrucao_t executa;
+  int opcode;
+  // argumento da instrução, já lido da memória (se a instrução tiver um)
+  bool tem_A1;
+  int A1;
+  // número de palavras de memória usadas pela entrada (a instrução e as que
+  //   foram fundidas a ela)
+  int tam;
+  // superinstrução: as instruções seguintes a esta que podem ser executadas
+  //   junto com ela, sem voltar ao laço de execução
+  int n_fundidas;
+  struct {
+    f_instrucao_t executa;
+    bool tem_A1;
+    int A1;
+  } fundidas[MAX_FUNDIDAS];
+} instr_decod_t;
+
 // uma CPU tem estado, memória, controlador de ES
 struct cpu_t {
   // registradores
@@ -40,8 +67,16 @@ struct cpu_t {
   // função e argumento para implementar instrução CHAMAC
   func_chamaC_t func_chamaC;
   void *arg_chamaC;
+  // cache de instruções decodificadas, indexado pelo endereço físico
+  instr_decod_t *cache;
+  int tam_cache;
+  // argumento da instrução em execução, quando veio do cache
+  bool A1_do_cache;
+  int A1_cache;
 };
 
+static void cpu_invalida_cache(void *arg, int endereco, int n);
+
 
 // ---------------------------------------------------------------------
 // CRIAÇÃO {{{1
@@ -74,12 +109,23 @@ cpu_t *cpu_cria(mmu_t *mmu, es_t *es)
   self->privilegiadas[RETI] = true;
   self->privilegiadas[CHAMAC] = true;
 
+  // inicializa o cache de instruções, com todas as entradas inválidas
+  //   a memória avisa a CPU das escritas, para que o cache seja invalidado
+  mem_t *mem = mmu_mem(self->mmu);
+  self->tam_cache = mem_tam(mem);
+  self->cache = calloc(self->tam_cache, sizeof(*self->cache));
+  assert(self->cache != NULL);
+  self->A1_do_cache = false;
+  mem_define_aviso_escrita(mem, cpu_invalida_cache, self);
+
   return self;
 }
 
 void cpu_destroi(cpu_t *self)
 {
   // quem criou mmu e e/s que destrua!
+  mem_define_aviso_escrita(mmu_mem(self->mmu), NULL, NULL);
+  free(self->cache);
   free(self);
 }
 
@@ -160,6 +206,15 @@ static bool pega_mem(cpu_t *self, int endereco, int *pval)
   return false;
 }
 
+// lê da memória um valor da instrução no PC (opcode ou argumento)
+static bool pega_instr(cpu_t *self, int endereco, int *pval)
+{
+  self->erro = mmu_busca(self->mmu, endereco, pval, self->modo);
+  if (self->erro == ERR_OK) return true;
+  self->complemento = endereco;
+  return false;
+}
+
 // escreve um valor na memória
 static bool poe_mem(cpu_t *self, int endereco, int val)
 {
@@ -193,18 +248,25 @@ static bool poe_es(cpu_t *self, int dispositivo, int val)
 static bool pega_opcode(cpu_t *self, int *popc)
 {
   // não pode executar se houver erro na leitura da memória
-  if (!pega_mem(self, self->PC, popc)) return false;
-  // pode executar se tiver privilégio para isso
-  if (self->modo == supervisor || !self->privilegiadas[*popc]) return true;
+  if (!pega_instr(self, self->PC, popc)) return false;
+  // pode executar se tiver privilégio para isso (opcode inválido é tratado
+  //   na execução)
+  if (self->modo == supervisor || *popc < 0 || *popc >= N_OPCODE
+      || !self->privilegiadas[*popc]) return true;
   // não pode executar instrução privilegiada em modo usuário
   self->erro = ERR_INSTR_PRIV;
   return false;
 }
 
 // lê o argumento 1 da instrução no PC
+// se a instrução veio do cache, o argumento já foi lido
 static bool pega_A1(cpu_t *self, int *pA1)
 {
-  return pega_mem(self, self->PC + 1, pA1);
+  if (self->A1_do_cache) {
+    *pA1 = self->A1_cache;
+    return true;
+  }
+  return pega_instr(self, self->PC + 1, pA1);
 }
 
 
@@ -448,52 +510,249 @@ static void op_CHAMAS(cpu_t *self) // chamada de sistema
 
 
 // ---------------------------------------------------------------------
-// EXECUÇÃO DE UMA INSTRUÇÃO {{{1
+// DECODIFICAÇÃO {{{1
 // ---------------------------------------------------------------------
 
+// função que executa cada instrução, indexada pelo opcode
+// as posições sem função (pseudo-instruções) são instruções inválidas
+static const f_instrucao_t funcoes_das_instrucoes[N_OPCODE] = {
+  [NOP]    = op_NOP,
+  [PARA]   = op_PARA,
+  [CARGI]  = op_CARGI,
+  [CARGM]  = op_CARGM,
+  [CARGX]  = op_CARGX,
+  [ARMM]   = op_ARMM,
+  [ARMX]   = op_ARMX,
+  [TRAX]   = op_TRAX,
+  [CPXA]   = op_CPXA,
+  [INCX]   = op_INCX,
+  [SOMA]   = op_SOMA,
+  [SUB]    = op_SUB,
+  [MULT]   = op_MULT,
+  [DIV]    = op_DIV,
+  [RESTO]  = op_RESTO,
+  [NEG]    = op_NEG,
+  [DESV]   = op_DESV,
+  [DESVZ]  = op_DESVZ,
+  [DESVNZ] = op_DESVNZ,
+  [DESVN]  = op_DESVN,
+  [DESVP]  = op_DESVP,
+  [CHAMA]  = op_CHAMA,
+  [RET]    = op_RET,
+  [LE]     = op_LE,
+  [ESCR]   = op_ESCR,
+  [RETI]   = op_RETI,
+  [CHAMAC] = op_CHAMAC,
+  [CHAMAS] = op_CHAMAS,
+};
+
+// retorna a função que executa a instrução, ou NULL se o opcode for inválido
+static f_instrucao_t funcao_da_instrucao(int opcode)
+{
+  if (opcode < 0 || opcode >= N_OPCODE) return NULL;
+  return funcoes_das_instrucoes[opcode];
+}
+
 static void executa_a_instrucao(cpu_t *self, int opcode)
+{
+  f_instrucao_t executa = funcao_da_instrucao(opcode);
+  if (executa == NULL) {
+    self->erro = ERR_INSTR_INV;
+    return;
+  }
+  executa(self);
+}
+
+
+// ---------------------------------------------------------------------
+// CACHE DE INSTRUÇÕES DECODIFICADAS {{{1
+// ---------------------------------------------------------------------
+
+// a decodificação de uma instrução (leitura do opcode e do argumento, escolha
+//   da função que a executa) é guardada em um cache indexado pelo endereço
+//   físico da instrução, e reaproveitada até que a memória nesse endereço seja
+//   alterada.
+// como a chave é o endereço físico, mudanças na tabela de páginas não
+//   invalidam o cache: o PC continua sendo traduzido a cada instrução (o que
+//   mantém as faltas de página e os bits de acesso como antes), só a leitura
+//   e a decodificação são evitadas.
+
+// sequências de instruções que não acessam a memória nem podem causar erro
+//   são fundidas em uma superinstrução, guardada na entrada da primeira:
+//   instruções que só alteram registradores, terminadas opcionalmente por um
+//   desvio ou uma chamada de sistema (como "cargi x / trax / cargi SO_ESCR /
+//   chamas", usada nas chamadas de sistema). Como nenhuma delas pode causar
+//   erro, executar a sequência de uma vez resulta no mesmo estado que
+//   executá-las uma a uma; só é feito se o lote em execução comportar todas
+//   (ver cpu_executa_n), para que as interrupções ocorram nos mesmos pontos.
+// as instruções de uma entrada (e seus argumentos) estão todas em um mesmo
+//   quadro da memória, porque a tradução de endereços só é feita no início.
+
+// chamada pela memória a cada escrita, com os 'n' endereços alterados a
+//   partir de 'endereco'
+// invalida as instruções decodificadas que usam os endereços alterados
+static void cpu_invalida_cache(void *arg, int endereco, int n)
+{
+  cpu_t *self = arg;
+  int fim = endereco + n;
+  if (fim > self->tam_cache) fim = self->tam_cache;
+  // entradas que começam no bloco alterado
+  for (int end = endereco; end < fim; end++) {
+    self->cache[end].executa = NULL;
+  }
+  // o primeiro endereço pode fazer parte de uma entrada que começa antes
+  //   dele, no mesmo quadro
+  for (int k = 1; k < TAM_PAGINA && k <= endereco; k++) {
+    instr_decod_t *instr = &self->cache[endereco - k];
+    if (instr->executa != NULL && k < instr->tam) {
+      instr->executa = NULL;
+    }
+  }
+}
+
+// retorna true se a instrução só altera registradores, sem poder causar erro,
+//   e pode ser seguida de outras em uma superinstrução
+static bool instrucao_fundivel(int opcode)
 {
   switch (opcode) {
-    case NOP:    op_NOP(self);    break;
-    case PARA:   op_PARA(self);   break;
-    case CARGI:  op_CARGI(self);  break;
-    case CARGM:  op_CARGM(self);  break;
-    case CARGX:  op_CARGX(self);  break;
-    case ARMM:   op_ARMM(self);   break;
-    case ARMX:   op_ARMX(self);   break;
-    case TRAX:   op_TRAX(self);   break;
-    case CPXA:   op_CPXA(self);   break;
-    case INCX:   op_INCX(self);   break;
-    case SOMA:   op_SOMA(self);   break;
-    case SUB:    op_SUB(self);    break;
-    case MULT:   op_MULT(self);   break;
-    case DIV:    op_DIV(self);    break;
-    case RESTO:  op_RESTO(self);  break;
-    case NEG:    op_NEG(self);    break;
-    case DESV:   op_DESV(self);   break;
-    case DESVZ:  op_DESVZ(self);  break;
-    case DESVNZ: op_DESVNZ(self); break;
-    case DESVN:  op_DESVN(self);  break;
-    case DESVP:  op_DESVP(self);  break;
-    case CHAMA:  op_CHAMA(self);  break;
-    case RET:    op_RET(self);    break;
-    case LE:     op_LE(self);     break;
-    case ESCR:   op_ESCR(self);   break;
-    case RETI:   op_RETI(self);   break;
-    case CHAMAC: op_CHAMAC(self); break;
-    case CHAMAS: op_CHAMAS(self); break;
-    default:     self->erro = ERR_INSTR_INV;
+    case NOP:
+    case CARGI:
+    case TRAX:
+    case CPXA:
+    case INCX:
+    case NEG:
+      return true;
+    default:
+      return false;
   }
 }
 
-void cpu_executa_1(cpu_t *self)
+// retorna true se a instrução pode terminar uma superinstrução
+static bool instrucao_termina_fusao(int opcode)
 {
-  // não executa se CPU já estiver em erro
-  if (self->erro != ERR_OK) return;
+  switch (opcode) {
+    case DESV:
+    case DESVZ:
+    case DESVNZ:
+    case DESVN:
+    case DESVP:
+    case CHAMAS:
+      return true;
+    default:
+      return false;
+  }
+}
 
+// lê e decodifica a instrução no endereço físico 'endfis'
+// retorna false se a instrução for inválida ou se ela (com o argumento) não
+//   estiver inteira no quadro de 'endfis'
+static bool decodifica(mem_t *mem, int endfis, int *popcode, f_instrucao_t *pexecuta,
+                       bool *ptem_A1, int *pA1)
+{
+  if (mem_le(mem, endfis, popcode) != ERR_OK) return false;
+  *pexecuta = funcao_da_instrucao(*popcode);
+  if (*pexecuta == NULL) return false;
+  *ptem_A1 = (instrucao_num_args(*popcode) == 1);
+  if (*ptem_A1) {
+    // o argumento só pode ser pré-lido se estiver no mesmo quadro do opcode,
+    //   senão a tradução dele pode ser outra (ou causar falta de página)
+    if (endfis % TAM_PAGINA == TAM_PAGINA - 1) return false;
+    if (mem_le(mem, endfis + 1, pA1) != ERR_OK) return false;
+  }
+  return true;
+}
+
+// funde à instrução em 'instr' (no endereço 'endfis') as instruções
+//   seguintes que formam uma superinstrução com ela
+static void forma_superinstrucao(cpu_t *self, instr_decod_t *instr, int endfis)
+{
+  mem_t *mem = mmu_mem(self->mmu);
+  int quadro = endfis / TAM_PAGINA;
+  int end = endfis + instr->tam;
+  while (instr->n_fundidas < MAX_FUNDIDAS && end / TAM_PAGINA == quadro) {
+    int opcode;
+    f_instrucao_t executa;
+    bool tem_A1;
+    int A1 = 0;
+    if (!decodifica(mem, end, &opcode, &executa, &tem_A1, &A1)) break;
+    bool termina = instrucao_termina_fusao(opcode);
+    if (!termina && !instrucao_fundivel(opcode)) break;
+    instr->fundidas[instr->n_fundidas].executa = executa;
+    instr->fundidas[instr->n_fundidas].tem_A1 = tem_A1;
+    instr->fundidas[instr->n_fundidas].A1 = A1;
+    instr->n_fundidas++;
+    end += tem_A1 ? 2 : 1;
+    if (termina) break;
+  }
+  instr->tam = end - endfis;
+}
+
+// retorna a instrução no PC decodificada, ou NULL se ela não puder vir do
+//   cache -- nesse caso, ela deve ser executada pelo caminho normal, que
+//   trata os erros
+static instr_decod_t *pega_instrucao_decodificada(cpu_t *self)
+{
+  int endfis;
+  if (mmu_traduz(self->mmu, self->PC, &endfis, self->modo) != ERR_OK) return NULL;
+  if (endfis < 0 || endfis >= self->tam_cache) return NULL;
+  instr_decod_t *instr = &self->cache[endfis];
+  if (instr->executa != NULL) return instr;
+
+  // não está no cache, decodifica
   int opcode;
-  if (pega_opcode(self, &opcode)) {
-    executa_a_instrucao(self, opcode);
+  f_instrucao_t executa;
+  if (!decodifica(mmu_mem(self->mmu), endfis, &opcode, &executa,
+                  &instr->tem_A1, &instr->A1)) {
+    return NULL;
+  }
+  instr->opcode = opcode;
+  instr->tam = instr->tem_A1 ? 2 : 1;
+  instr->n_fundidas = 0;
+  if (instrucao_fundivel(opcode)) {
+    forma_superinstrucao(self, instr, endfis);
+  }
+  instr->executa = executa;
+  return instr;
+}
+
+// executa a superinstrução em 'instr': a instrução e as fundidas a ela
+static void executa_superinstrucao(cpu_t *self, instr_decod_t *instr)
+{
+  self->A1_do_cache = instr->tem_A1;
+  self->A1_cache = instr->A1;
+  instr->executa(self);
+  for (int i = 0; i < instr->n_fundidas; i++) {
+    self->A1_do_cache = instr->fundidas[i].tem_A1;
+    self->A1_cache = instr->fundidas[i].A1;
+    instr->fundidas[i].executa(self);
+  }
+  self->A1_do_cache = false;
+}
+
+
+// ---------------------------------------------------------------------
+// EXECUÇÃO DE UMA INSTRUÇÃO {{{1
+// ---------------------------------------------------------------------
+
+// executa a instrução no PC; 'instr' é ela decodificada, ou NULL se não
+//   estiver no cache
+static void executa_instrucao_no_pc(cpu_t *self, instr_decod_t *instr)
+{
+  if (instr != NULL) {
+    // instrução já decodificada: vai direto para a função que a executa
+    if (self->modo == usuario && self->privilegiadas[instr->opcode]) {
+      self->erro = ERR_INSTR_PRIV;
+    } else {
+      self->A1_do_cache = instr->tem_A1;
+      self->A1_cache = instr->A1;
+      instr->executa(self);
+      self->A1_do_cache = false;
+    }
+  } else {
+    int opcode;
+    if (pega_opcode(self, &opcode)) {
+      executa_a_instrucao(self, opcode);
+    }
   }
 
   // se a CPU entrou em erro, causa uma interrupção
@@ -507,6 +766,63 @@ void cpu_executa_1(cpu_t *self)
   }
 }
 
+void cpu_executa_1(cpu_t *self)
+{
+  // não executa se CPU já estiver em erro
+  if (self->erro != ERR_OK) return;
+
+  executa_instrucao_no_pc(self, pega_instrucao_decodificada(self));
+}
+
+// retorna true se a instrução interage com o resto do sistema (dispositivos,
+//   SO, interrupção), e por isso deve ver o relógio atualizado
+static bool instrucao_interage(int opcode)
+{
+  switch (opcode) {
+    case PARA:
+    case LE:
+    case ESCR:
+    case RETI:
+    case CHAMAC:
+    case CHAMAS:
+      return true;
+    default:
+      return false;
+  }
+}
+
+int cpu_executa_n(cpu_t *self, int max, func_avanca_t avanca, void *arg)
+{
+  int n = 0;
+  int n_avancadas = 0;
+  cpu_modo_t modo = self->modo;
+  while (n < max && self->erro == ERR_OK) {
+    instr_decod_t *instr = pega_instrucao_decodificada(self);
+    // superinstrução, se couber inteira no lote
+    // nenhuma das instruções é privilegiada ou pode causar erro; só a chamada
+    //   de sistema, se estiver no final, muda o modo da CPU
+    if (instr != NULL && instr->n_fundidas > 0
+        && n + 1 + instr->n_fundidas <= max) {
+      executa_superinstrucao(self, instr);
+      n += 1 + instr->n_fundidas;
+      if (self->modo != modo) break;
+      continue;
+    }
+    // instrução fora do cache pode causar erro ou interagir, é tratada como
+    //   se interagisse
+    bool interage = (instr == NULL || instrucao_interage(instr->opcode));
+    if (interage && n > n_avancadas) {
+      avanca(arg, n - n_avancadas);
+      n_avancadas = n;
+    }
+    executa_instrucao_no_pc(self, instr);
+    n++;
+    if (interage || self->erro != ERR_OK || self->modo != modo) break;
+  }
+  if (n > n_avancadas) avanca(arg, n - n_avancadas);
+  return n;
+}
+
 
 // ---------------------------------------------------------------------
 // INTERRUPÇÃO {{{1
@@ -549,6 +865,11 @@ bool cpu_interrompe(cpu_t *self, irq_t irq)
   return true;
 }
 
+bool cpu_parada(cpu_t *self)
+{
+  return self->erro != ERR_OK;
+}
+
 static void cpu_desinterrompe(cpu_t *self)
 {
   // a interrupção retornou
@@ -51,6 +51,24 @@ void cpu_destroi(cpu_t *self);
 //     e causa uma interrupção
 void cpu_executa_1(cpu_t *self);
 
+// tipo da função chamada por cpu_executa_n para informar quantas instruções
+//   foram executadas (para que o relógio seja avançado)
+typedef void (*func_avanca_t)(void *arg, int n);
+
+// executa até 'max' instruções, como chamadas sucessivas a cpu_executa_1,
+//   sem sair da CPU entre elas
+// para depois de uma instrução que causa erro ou interrupção, ou que interage
+//   com o resto do sistema (E/S, chamada ao SO, retorno de interrupção, PARA)
+// a função 'avanca' é chamada com o número de instruções executadas antes de
+//   executar uma instrução que interage com o sistema (para que ela veja o
+//   relógio com o valor certo) e no final, com as demais
+// retorna o número de instruções executadas (0 se a CPU estiver em erro)
+int cpu_executa_n(cpu_t *self, int max, func_avanca_t avanca, void *arg);
+
+// retorna true se a CPU não está executando instruções (está em erro, ou
+//   parada pela instrução PARA) -- só sai desse estado com uma interrupção
+bool cpu_parada(cpu_t *self);
+
 // implementa uma interrupção
 // passa para modo supervisor, salva o estado da CPU no início da memória,
 //   altera A para identificar a requisição de interrupção, altera PC para
@@ -17,6 +17,7 @@ typedef enum {
   ERR_OCUP,          // dispositivo ocupado
   ERR_INSTR_PRIV,    // instrução privilegiada
   ERR_PAG_AUSENTE,   // página de memória não mapeada
+  ERR_PAG_PROTEGIDA, // acesso não permitido pelas permissões da página
   N_ERR              // número de erros
 } err_t;
 
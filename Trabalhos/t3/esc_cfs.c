@@ -0,0 +1,168 @@
+// esc_cfs.c
+// política de escalonamento CFS (completely fair scheduler)
+// simulador de computador
+// so25b
+
+// divide a CPU entre os processos que a disputam na proporção dos pesos
+//   (PESO_PADRAO, ou o definido por SO_PESO_PROC). Cada processo tem um
+//   tempo virtual de execução (vruntime), que aumenta com as instruções que
+//   ele executa, divididas pelo peso relativo ao padrão: quem tem o dobro do
+//   peso tem o vruntime aumentado à metade da velocidade. O escolhido é
+//   sempre o pronto de menor vruntime, o que mais ficou para trás
+// a fatia de tempo do escolhido não é fixa: é a parte dele, pelo peso, de
+//   CFS_LATENCIA instruções divididas entre todos os que disputam a CPU, mas
+//   no mínimo CFS_GRANULARIDADE (com muitos processos, a fatia proporcional
+//   seria pequena demais e o tempo iria para as trocas)
+// quem fica pronto depois de bloqueado recebe no máximo meia latência de
+//   vantagem sobre o menor vruntime, para que um processo que dormiu muito
+//   não fique com a CPU até alcançar os outros; e toma a CPU do corrente se
+//   o corrente ficou mais que uma fatia à frente dele
+// o tempo executado vem do relógio de instruções (ver so_atualiza_tempos); os
+//   prontos ficam em um heap pelo vruntime (ver heap.h): escolher custa
+//   O(log n)
+
+#include "escalonador.h"
+#include "processo.h"
+#include "heap.h"
+#include "console.h"
+#include <stdlib.h>
+#include <assert.h>
+
+// em instruções
+#define CFS_LATENCIA 1000
+#define CFS_GRANULARIDADE 100
+
+typedef struct {
+  heap_t *prontos;      // pelo vruntime
+  int peso_prontos;     // soma dos pesos dos prontos
+  double vruntime_min;  // menor vruntime entre os que disputam a CPU (só aumenta)
+  int escolhas;         // para o relatório: processos escolhidos
+  long soma_fatias;     //   e a soma das fatias deles
+} cfs_t;
+
+static void *cfs_cria(void)
+{
+  cfs_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->prontos = heap_cria();
+  self->peso_prontos = 0;
+  self->vruntime_min = 0;
+  self->escolhas = 0;
+  self->soma_fatias = 0;
+  return self;
+}
+
+static void cfs_destroi(void *dados)
+{
+  cfs_t *self = dados;
+  heap_destroi(self->prontos);
+  free(self);
+}
+
+// o vruntime mínimo só aumenta, para servir de base a quem fica pronto
+static void cfs_atualiza_min(cfs_t *self, double vruntime)
+{
+  if (!heap_vazio(self->prontos) && heap_chave_min(self->prontos) < vruntime) {
+    vruntime = heap_chave_min(self->prontos);
+  }
+  if (vruntime > self->vruntime_min) self->vruntime_min = vruntime;
+}
+
+static void cfs_pronto(void *dados, pcb *proc)
+{
+  cfs_t *self = dados;
+  // um processo novo (vruntime 0) ou que dormiu fica no máximo meia latência
+  //   atrás; quem perdeu a CPU já está à frente do mínimo
+  double piso = self->vruntime_min - CFS_LATENCIA / 2;
+  if (proc->vruntime < piso) proc->vruntime = piso;
+  heap_insere(self->prontos, proc, proc->vruntime);
+  self->peso_prontos += proc->peso;
+}
+
+static pcb *cfs_proximo(void *dados)
+{
+  cfs_t *self = dados;
+  pcb *proc = heap_retira_min(self->prontos);
+  if (proc == NULL) return NULL;
+  self->peso_prontos -= proc->peso;
+  cfs_atualiza_min(self, proc->vruntime);
+  // a fatia é a parte do processo na latência, pelo peso
+  int soma_pesos = self->peso_prontos + proc->peso;
+  proc->fatia = (long)CFS_LATENCIA * proc->peso / soma_pesos;
+  if (proc->fatia < CFS_GRANULARIDADE) proc->fatia = CFS_GRANULARIDADE;
+  proc->executado_fatia = 0;
+  self->escolhas++;
+  self->soma_fatias += proc->fatia;
+  return proc;
+}
+
+static void cfs_executou(void *dados, pcb *proc, int tempo)
+{
+  cfs_t *self = dados;
+  proc->vruntime += (double)tempo * PESO_PADRAO / proc->peso;
+  proc->executado_fatia += tempo;
+  cfs_atualiza_min(self, proc->vruntime);
+}
+
+// o corrente sai quando gasta a fatia
+static bool cfs_relogio(void *dados, pcb *corrente)
+{
+  if (corrente == NULL || corrente->estado != P_EXECUTANDO) return false;
+  return corrente->executado_fatia >= corrente->fatia;
+}
+
+// um pronto toma a CPU do corrente se o corrente, depois de executar um
+//   mínimo, está mais que uma fatia à frente dele; a fatia é em instruções,
+//   e é convertida para tempo virtual pelo peso do corrente
+static bool cfs_preempta(void *dados, pcb *corrente)
+{
+  cfs_t *self = dados;
+  if (heap_vazio(self->prontos) || corrente->executado_fatia < CFS_GRANULARIDADE) {
+    return false;
+  }
+  double fatia_virtual = (double)corrente->fatia * PESO_PADRAO / corrente->peso;
+  return corrente->vruntime - heap_chave_min(self->prontos) > fatia_virtual;
+}
+
+static void cfs_terminou(void *dados, pcb *proc)
+{
+  cfs_t *self = dados;
+  if (proc->pos_heap < 0) return;
+  heap_retira(self->prontos, proc);
+  self->peso_prontos -= proc->peso;
+}
+
+static void cfs_imprime(void *dados)
+{
+  cfs_t *self = dados;
+  heap_imprime(self->prontos);
+}
+
+static void cfs_relatorio_configuracao(void *dados)
+{
+  console_printf(" - Política de Escalonamento: CFS (latência de %d instruções, fatia mínima de %d)",
+  CFS_LATENCIA, CFS_GRANULARIDADE);
+  console_printf(" - Quantum: fatia proporcional ao peso (peso padrão %d)", PESO_PADRAO);
+}
+
+static void cfs_relatorio(void *dados)
+{
+  cfs_t *self = dados;
+  console_printf("   CFS: %d escolhas, fatia média de %.1f instruções",
+  self->escolhas, self->escolhas > 0 ? (double)self->soma_fatias / self->escolhas : 0.0);
+}
+
+esc_ops_t esc_ops_cfs = {
+  .nome = "cfs",
+  .cria = cfs_cria,
+  .destroi = cfs_destroi,
+  .pronto = cfs_pronto,
+  .proximo = cfs_proximo,
+  .relogio = cfs_relogio,
+  .executou = cfs_executou,
+  .preempta = cfs_preempta,
+  .terminou = cfs_terminou,
+  .imprime = cfs_imprime,
+  .relatorio_configuracao = cfs_relatorio_configuracao,
+  .relatorio = cfs_relatorio,
+};
@@ -0,0 +1,148 @@
+// esc_justa.c
+// política de escalonamento por fração justa (fair share) entre terminais
+// simulador de computador
+// so25b
+
+// a CPU é dividida igualmente entre os grupos de processos, e não entre os
+//   processos: cada terminal é um grupo (os clones ficam no terminal de quem
+//   os criou), então quem tem muitos processos não tira CPU dos outros
+//   terminais. Cada grupo tem a sua fila de prontos (round robin dentro do
+//   grupo, com quantum QUANTUM) e um uso recente da CPU, que aumenta a cada
+//   interrupção de relógio em que um processo do grupo está executando e cai
+//   à metade a cada JUSTA_PERIODO_DECAIMENTO interrupções. O escolhido é o
+//   primeiro da fila do grupo com prontos de menor uso recente (nos empates,
+//   o grupo seguinte ao último escolhido)
+// escolher custa O(JUSTA_GRUPOS)
+
+#include "escalonador.h"
+#include "processo.h"
+#include "fila.h"
+#include "console.h"
+#include <stdlib.h>
+#include <assert.h>
+
+#define JUSTA_GRUPOS 4  // um por terminal
+#define JUSTA_PERIODO_DECAIMENTO 50
+
+typedef struct {
+  fila filas[JUSTA_GRUPOS];     // prontos de cada grupo
+  int uso[JUSTA_GRUPOS];        // uso recente da CPU de cada grupo
+  int uso_total[JUSTA_GRUPOS];  // interrupções de relógio executando, no total
+  int ultimo;                   // último grupo escolhido
+  int tics;                     // interrupções desde o último decaimento
+} justa_t;
+
+static void *justa_cria(void)
+{
+  justa_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  for (int g = 0; g < JUSTA_GRUPOS; g++) {
+    fila_inicializa(&self->filas[g]);
+    self->uso[g] = 0;
+    self->uso_total[g] = 0;
+  }
+  self->ultimo = JUSTA_GRUPOS - 1;
+  self->tics = 0;
+  return self;
+}
+
+static void justa_destroi(void *dados)
+{
+  justa_t *self = dados;
+  for (int g = 0; g < JUSTA_GRUPOS; g++) {
+    while (desenfileira(&self->filas[g]) != NULL) ;
+  }
+  free(self);
+}
+
+// o grupo do processo é o terminal que ele usa
+static int justa_grupo(pcb *proc)
+{
+  int g = (proc->entrada - D_TERM_A) / (D_TERM_B - D_TERM_A);
+  if (g < 0 || g >= JUSTA_GRUPOS) g = 0;
+  return g;
+}
+
+static void justa_pronto(void *dados, pcb *proc)
+{
+  justa_t *self = dados;
+  enfileira(&self->filas[justa_grupo(proc)], proc);
+}
+
+static pcb *justa_proximo(void *dados)
+{
+  justa_t *self = dados;
+  int escolhido = -1;
+  for (int i = 1; i <= JUSTA_GRUPOS; i++) {
+    int g = (self->ultimo + i) % JUSTA_GRUPOS;
+    if (fila_vazia(&self->filas[g])) continue;
+    if (escolhido == -1 || self->uso[g] < self->uso[escolhido]) escolhido = g;
+  }
+  if (escolhido == -1) return NULL;
+  self->ultimo = escolhido;
+  return desenfileira(&self->filas[escolhido]);
+}
+
+static bool justa_relogio(void *dados, pcb *corrente)
+{
+  justa_t *self = dados;
+  if (++self->tics >= JUSTA_PERIODO_DECAIMENTO) {
+    self->tics = 0;
+    for (int g = 0; g < JUSTA_GRUPOS; g++) {
+      self->uso[g] /= 2;
+    }
+  }
+  if (corrente == NULL) return false;
+  if (corrente->estado == P_EXECUTANDO) {
+    int g = justa_grupo(corrente);
+    self->uso[g]++;
+    self->uso_total[g]++;
+  }
+  corrente->quantum--;
+  if (corrente->quantum > 0 || corrente->estado == P_BLOQUEADO) return false;
+  corrente->quantum = QUANTUM;
+  return true;
+}
+
+static void justa_terminou(void *dados, pcb *proc)
+{
+  justa_t *self = dados;
+  if (proc->fila == &self->filas[justa_grupo(proc)]) fila_retira(proc);
+}
+
+static void justa_imprime(void *dados)
+{
+  justa_t *self = dados;
+  for (int g = 0; g < JUSTA_GRUPOS; g++) {
+    if (fila_vazia(&self->filas[g])) continue;
+    console_printf("Terminal %c (uso %d):", 'A' + g, self->uso[g]);
+    imprime_fila(&self->filas[g]);
+  }
+}
+
+static void justa_relatorio_configuracao(void *dados)
+{
+  console_printf(" - Política de Escalonamento: fração justa entre terminais (uso cai à metade a cada %d interrupções de relógio)",
+  JUSTA_PERIODO_DECAIMENTO);
+  console_printf(" - Quantum: %d", QUANTUM);
+}
+
+static void justa_relatorio(void *dados)
+{
+  justa_t *self = dados;
+  console_printf("   Fração justa: interrupções de relógio executando, por terminal: A %d, B %d, C %d, D %d",
+  self->uso_total[0], self->uso_total[1], self->uso_total[2], self->uso_total[3]);
+}
+
+esc_ops_t esc_ops_justa = {
+  .nome = "justa",
+  .cria = justa_cria,
+  .destroi = justa_destroi,
+  .pronto = justa_pronto,
+  .proximo = justa_proximo,
+  .relogio = justa_relogio,
+  .terminou = justa_terminou,
+  .imprime = justa_imprime,
+  .relatorio_configuracao = justa_relatorio_configuracao,
+  .relatorio = justa_relatorio,
+};
@@ -0,0 +1,192 @@
+// esc_mlfq.c
+// política de escalonamento MLFQ (multilevel feedback queue)
+// simulador de computador
+// so25b
+
+// uma fila de prontos por nível de prioridade, com quantum maior nos níveis
+//   mais baixos (MLFQ_QUANTUM << nível). Escolhe o primeiro da fila mais alta
+//   não vazia, e um processo que fica pronto em um nível mais alto que o do
+//   que está executando toma a CPU dele. Quem gasta o quantum todo desce um
+//   nível; quem é desbloqueado depois de E/S sobe um. O quantum não é
+//   renovado quando o processo bloqueia, então bloquear pouco antes de acabar
+//   o quantum não segura o processo no nível. A cada MLFQ_PERIODO_BOOST
+//   interrupções de relógio, todos voltam ao nível 0, para que os processos
+//   dos níveis baixos não fiquem sem executar: os prontos dos outros níveis
+//   vão já para a fila do nível 0, e os demais quando forem vistos de novo
+//   (o boost muda a época, e quem é de uma época anterior volta ao nível 0)
+// todas as operações custam O(1) (ou O(MLFQ_NIVEIS)), menos o boost, que
+//   percorre os prontos dos níveis baixos
+
+#include "escalonador.h"
+#include "processo.h"
+#include "fila.h"
+#include "console.h"
+#include <stdlib.h>
+#include <assert.h>
+
+// número de níveis, quantum do nível 0 (dobra a cada nível abaixo) e
+//   interrupções de relógio entre os boosts
+#define MLFQ_NIVEIS 3
+#define MLFQ_QUANTUM 5
+#define MLFQ_PERIODO_BOOST 100
+
+typedef struct {
+  fila filas[MLFQ_NIVEIS];  // 0 é o nível de maior prioridade
+  int epoca_boost;
+  int tics_desde_boost;     // interrupções de relógio desde o último boost
+  int rebaixamentos;        // processos que desceram de nível (quantum gasto)
+  int promocoes;            // processos que subiram de nível (depois de E/S)
+  int boosts;               // vezes em que todos voltaram ao nível 0
+} mlfq_t;
+
+static void *mlfq_cria(void)
+{
+  mlfq_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  for (int n = 0; n < MLFQ_NIVEIS; n++) {
+    fila_inicializa(&self->filas[n]);
+  }
+  self->epoca_boost = 0;
+  self->tics_desde_boost = 0;
+  self->rebaixamentos = 0;
+  self->promocoes = 0;
+  self->boosts = 0;
+  return self;
+}
+
+static void mlfq_destroi(void *dados)
+{
+  mlfq_t *self = dados;
+  for (int n = 0; n < MLFQ_NIVEIS; n++) {
+    while (desenfileira(&self->filas[n]) != NULL) ;
+  }
+  free(self);
+}
+
+static int mlfq_quantum_nivel(int nivel)
+{
+  return MLFQ_QUANTUM << nivel;
+}
+
+// se houve um boost desde a última vez que o processo foi visto, ele volta
+//   ao nível 0 com o quantum do nível
+static void mlfq_atualiza_epoca(mlfq_t *self, pcb *proc)
+{
+  if (proc->epoca_boost == self->epoca_boost) return;
+  proc->epoca_boost = self->epoca_boost;
+  proc->nivel = 0;
+  proc->quantum = mlfq_quantum_nivel(0);
+}
+
+static void mlfq_pronto(void *dados, pcb *proc)
+{
+  mlfq_t *self = dados;
+  mlfq_atualiza_epoca(self, proc);
+  enfileira(&self->filas[proc->nivel], proc);
+}
+
+static pcb *mlfq_proximo(void *dados)
+{
+  mlfq_t *self = dados;
+  for (int n = 0; n < MLFQ_NIVEIS; n++) {
+    if (!fila_vazia(&self->filas[n])) return desenfileira(&self->filas[n]);
+  }
+  return NULL;
+}
+
+// conta as interrupções de relógio e faz o boost; depois, o processo
+//   corrente gasta o quantum, e desce um nível se gastou todo
+static bool mlfq_relogio(void *dados, pcb *corrente)
+{
+  mlfq_t *self = dados;
+  if (++self->tics_desde_boost >= MLFQ_PERIODO_BOOST) {
+    self->tics_desde_boost = 0;
+    self->epoca_boost++;
+    self->boosts++;
+    for (int n = 1; n < MLFQ_NIVEIS; n++) {
+      pcb *proc;
+      while ((proc = desenfileira(&self->filas[n])) != NULL) {
+        mlfq_pronto(self, proc);
+      }
+    }
+  }
+  if (corrente == NULL) return false;
+  mlfq_atualiza_epoca(self, corrente);
+  corrente->quantum--;
+  if (corrente->quantum > 0 || corrente->estado == P_BLOQUEADO) return false;
+  if (corrente->nivel < MLFQ_NIVEIS - 1) {
+    corrente->nivel++;
+    self->rebaixamentos++;
+  }
+  corrente->quantum = mlfq_quantum_nivel(corrente->nivel);
+  return true;
+}
+
+// tem um processo pronto em um nível acima do corrente?
+static bool mlfq_preempta(void *dados, pcb *corrente)
+{
+  mlfq_t *self = dados;
+  mlfq_atualiza_epoca(self, corrente);
+  for (int n = 0; n < corrente->nivel; n++) {
+    if (!fila_vazia(&self->filas[n])) return true;
+  }
+  return false;
+}
+
+// o processo esperou E/S: sobe um nível
+static void mlfq_desbloqueou(void *dados, pcb *proc)
+{
+  mlfq_t *self = dados;
+  mlfq_atualiza_epoca(self, proc);
+  if (proc->nivel == 0) return;
+  proc->nivel--;
+  proc->quantum = mlfq_quantum_nivel(proc->nivel);
+  self->promocoes++;
+}
+
+static void mlfq_terminou(void *dados, pcb *proc)
+{
+  mlfq_t *self = dados;
+  if (proc->fila >= &self->filas[0] && proc->fila < &self->filas[MLFQ_NIVEIS]) {
+    fila_retira(proc);
+  }
+}
+
+static void mlfq_imprime(void *dados)
+{
+  mlfq_t *self = dados;
+  for (int n = 0; n < MLFQ_NIVEIS; n++) {
+    if (fila_vazia(&self->filas[n])) continue;
+    console_printf("Nível %d:", n);
+    imprime_fila(&self->filas[n]);
+  }
+}
+
+static void mlfq_relatorio_configuracao(void *dados)
+{
+  console_printf(" - Política de Escalonamento: MLFQ (%d níveis, boost a cada %d interrupções de relógio)",
+  MLFQ_NIVEIS, MLFQ_PERIODO_BOOST);
+  console_printf(" - Quantum: %d no nível 0, dobrando a cada nível", MLFQ_QUANTUM);
+}
+
+static void mlfq_relatorio(void *dados)
+{
+  mlfq_t *self = dados;
+  console_printf("   MLFQ: %d rebaixamentos, %d promoções, %d boosts",
+  self->rebaixamentos, self->promocoes, self->boosts);
+}
+
+esc_ops_t esc_ops_mlfq = {
+  .nome = "mlfq",
+  .cria = mlfq_cria,
+  .destroi = mlfq_destroi,
+  .pronto = mlfq_pronto,
+  .proximo = mlfq_proximo,
+  .relogio = mlfq_relogio,
+  .preempta = mlfq_preempta,
+  .desbloqueou = mlfq_desbloqueou,
+  .terminou = mlfq_terminou,
+  .imprime = mlfq_imprime,
+  .relatorio_configuracao = mlfq_relatorio_configuracao,
+  .relatorio = mlfq_relatorio,
+};
@@ -0,0 +1,95 @@
+// esc_prio.c
+// política de escalonamento por prioridade
+// simulador de computador
+// so25b
+
+// a prioridade de cada processo é a média entre a prioridade anterior e a
+//   fração do quantum que ele usou da última vez que executou:
+//     prio = (prio + t_exec/QUANTUM) / 2
+//   e é recalculada quando ele deixa a CPU (bloqueando ou por fim do quantum).
+//   Menor valor é melhor, então quem bloqueia cedo (E/S) passa na frente de
+//   quem gasta o quantum todo. Um processo novo começa com 0.5
+// os prontos ficam em um heap pela prioridade: escolher custa O(log n), sem
+//   percorrer os processos
+// ao bloquear, o quantum é renovado, para que t_exec seja sempre o tempo
+//   desde que o processo foi escolhido
+
+#include "escalonador.h"
+#include "processo.h"
+#include "heap.h"
+#include "console.h"
+#include <stdlib.h>
+
+static void *prio_cria(void)
+{
+  return heap_cria();
+}
+
+static void prio_destroi(void *dados)
+{
+  heap_destroi(dados);
+}
+
+// o processo deixou a CPU depois de executar QUANTUM - quantum interrupções
+static void prio_atualiza(pcb *proc)
+{
+  double t_exec = QUANTUM - proc->quantum;
+  proc->prioridade = (proc->prioridade + t_exec / QUANTUM) / 2.0;
+  proc->quantum = QUANTUM;
+}
+
+static void prio_pronto(void *dados, pcb *proc)
+{
+  heap_insere(dados, proc, proc->prioridade);
+}
+
+static pcb *prio_proximo(void *dados)
+{
+  pcb *proc = heap_retira_min(dados);
+  if (proc != NULL) console_printf("SO: prioridade do processo %d: %.2f", proc->pid, proc->prioridade);
+  return proc;
+}
+
+static bool prio_relogio(void *dados, pcb *corrente)
+{
+  if (corrente == NULL) return false;
+  corrente->quantum--;
+  if (corrente->quantum > 0 || corrente->estado == P_BLOQUEADO) return false;
+  corrente->quantum = 0;
+  prio_atualiza(corrente);
+  return true;
+}
+
+static void prio_bloqueou(void *dados, pcb *proc)
+{
+  prio_atualiza(proc);
+}
+
+static void prio_terminou(void *dados, pcb *proc)
+{
+  heap_retira(dados, proc);
+}
+
+static void prio_imprime(void *dados)
+{
+  heap_imprime(dados);
+}
+
+static void prio_relatorio_configuracao(void *dados)
+{
+  console_printf(" - Política de Escalonamento: prioridade (fração do quantum usada)");
+  console_printf(" - Quantum: %d", QUANTUM);
+}
+
+esc_ops_t esc_ops_prio = {
+  .nome = "prio",
+  .cria = prio_cria,
+  .destroi = prio_destroi,
+  .pronto = prio_pronto,
+  .proximo = prio_proximo,
+  .relogio = prio_relogio,
+  .bloqueou = prio_bloqueou,
+  .terminou = prio_terminou,
+  .imprime = prio_imprime,
+  .relatorio_configuracao = prio_relatorio_configuracao,
+};
@@ -0,0 +1,71 @@
+// esc_rr.c
+// política de escalonamento round robin
+// simulador de computador
+// so25b
+
+// uma fila de prontos, todos com o mesmo quantum (QUANTUM); quem gasta o
+//   quantum vai para o fim da fila. O quantum não é renovado quando o processo
+//   bloqueia
+
+#include "escalonador.h"
+#include "processo.h"
+#include "fila.h"
+#include "console.h"
+#include <stdlib.h>
+
+static void *rr_cria(void)
+{
+  return cria_fila();
+}
+
+static void rr_destroi(void *dados)
+{
+  destroi_fila(dados);
+}
+
+static void rr_pronto(void *dados, pcb *proc)
+{
+  enfileira(dados, proc);
+}
+
+static pcb *rr_proximo(void *dados)
+{
+  return desenfileira(dados);
+}
+
+static bool rr_relogio(void *dados, pcb *corrente)
+{
+  if (corrente == NULL) return false;
+  corrente->quantum--;
+  if (corrente->quantum > 0 || corrente->estado == P_BLOQUEADO) return false;
+  corrente->quantum = QUANTUM; // reseta o quantum
+  return true;
+}
+
+static void rr_terminou(void *dados, pcb *proc)
+{
+  if (proc->fila == dados) fila_retira(proc);
+}
+
+static void rr_imprime(void *dados)
+{
+  imprime_fila(dados);
+}
+
+static void rr_relatorio_configuracao(void *dados)
+{
+  console_printf(" - Política de Escalonamento: round robin");
+  console_printf(" - Quantum: %d", QUANTUM);
+}
+
+esc_ops_t esc_ops_rr = {
+  .nome = "rr",
+  .cria = rr_cria,
+  .destroi = rr_destroi,
+  .pronto = rr_pronto,
+  .proximo = rr_proximo,
+  .relogio = rr_relogio,
+  .terminou = rr_terminou,
+  .imprime = rr_imprime,
+  .relatorio_configuracao = rr_relatorio_configuracao,
+};
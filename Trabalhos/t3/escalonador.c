@@ -0,0 +1,120 @@
+// escalonador.c
+// escalonador de processos, com a política escolhida na inicialização
+// simulador de computador
+// so25b
+
+#include "escalonador.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// as políticas, na ordem de esc_politica_t
+static esc_ops_t *politicas[ESC_N_POLITICAS] = {
+  [ESC_ROUND_ROBIN]  = &esc_ops_rr,
+  [ESC_PRIORIDADE]   = &esc_ops_prio,
+  [ESC_MLFQ]         = &esc_ops_mlfq,
+  [ESC_FRACAO_JUSTA] = &esc_ops_justa,
+  [ESC_CFS]          = &esc_ops_cfs,
+};
+
+struct escalonador_t {
+  esc_politica_t politica;
+  esc_ops_t *ops;
+  void *dados;  // dados da política
+};
+
+escalonador_t *esc_cria(esc_politica_t politica)
+{
+  assert(politica >= 0 && politica < ESC_N_POLITICAS);
+  escalonador_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->politica = politica;
+  self->ops = politicas[politica];
+  self->dados = self->ops->cria();
+  return self;
+}
+
+void esc_destroi(escalonador_t *self)
+{
+  if (self == NULL) return;
+  if (self->ops->destroi != NULL) self->ops->destroi(self->dados);
+  free(self);
+}
+
+int esc_politica_por_nome(char *nome)
+{
+  for (int p = 0; p < ESC_N_POLITICAS; p++) {
+    if (strcmp(politicas[p]->nome, nome) == 0) return p;
+  }
+  return -1;
+}
+
+char *esc_nome_politica(esc_politica_t politica)
+{
+  if (politica < 0 || politica >= ESC_N_POLITICAS) return "?";
+  return politicas[politica]->nome;
+}
+
+esc_politica_t esc_politica(escalonador_t *self)
+{
+  return self->politica;
+}
+
+void esc_pronto(escalonador_t *self, struct pcb *proc)
+{
+  self->ops->pronto(self->dados, proc);
+}
+
+struct pcb *esc_proximo(escalonador_t *self)
+{
+  return self->ops->proximo(self->dados);
+}
+
+bool esc_relogio(escalonador_t *self, struct pcb *corrente)
+{
+  if (self->ops->relogio == NULL) return false;
+  return self->ops->relogio(self->dados, corrente);
+}
+
+void esc_executou(escalonador_t *self, struct pcb *proc, int tempo)
+{
+  if (self->ops->executou != NULL) self->ops->executou(self->dados, proc, tempo);
+}
+
+bool esc_preempta(escalonador_t *self, struct pcb *corrente)
+{
+  if (self->ops->preempta == NULL) return false;
+  return self->ops->preempta(self->dados, corrente);
+}
+
+void esc_bloqueou(escalonador_t *self, struct pcb *proc)
+{
+  if (self->ops->bloqueou != NULL) self->ops->bloqueou(self->dados, proc);
+}
+
+void esc_desbloqueou(escalonador_t *self, struct pcb *proc)
+{
+  if (self->ops->desbloqueou != NULL) self->ops->desbloqueou(self->dados, proc);
+}
+
+void esc_terminou(escalonador_t *self, struct pcb *proc)
+{
+  if (self->ops->terminou != NULL) self->ops->terminou(self->dados, proc);
+}
+
+void esc_imprime(escalonador_t *self)
+{
+  if (self->ops->imprime != NULL) self->ops->imprime(self->dados);
+}
+
+void esc_relatorio_configuracao(escalonador_t *self)
+{
+  if (self->ops->relatorio_configuracao != NULL) {
+    self->ops->relatorio_configuracao(self->dados);
+  }
+}
+
+void esc_relatorio(escalonador_t *self)
+{
+  if (self->ops->relatorio != NULL) self->ops->relatorio(self->dados);
+}
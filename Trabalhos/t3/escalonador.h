@@ -0,0 +1,105 @@
+// escalonador.h
+// escalonador de processos, com a política escolhida na inicialização
+// simulador de computador
+// so25b
+
+#ifndef ESCALONADOR_H
+#define ESCALONADOR_H
+
+// o SO não escolhe diretamente o processo a executar: ele avisa o escalonador
+//   do que acontece com os processos (ficou pronto, bloqueou, foi
+//   desbloqueado, terminou, passou uma interrupção de relógio) e pede a ele o
+//   próximo processo. Cada política é um módulo (esc_*.c) que implementa
+//   essas operações (esc_ops_t) sobre dados próprios; o SO só usa as funções
+//   esc_* abaixo, então trocar a política não muda o SO
+// o escalonador só guarda os processos prontos; quem está executando ou
+//   bloqueado fica com o SO. O quantum é controlado pela política (campo
+//   'quantum' do pcb)
+
+#include <stdbool.h>
+
+struct pcb;
+
+// políticas de escalonamento
+typedef enum {
+  ESC_ROUND_ROBIN,
+  ESC_PRIORIDADE,   // menor uso recente do quantum primeiro (ver esc_prio.c)
+  ESC_MLFQ,         // multilevel feedback queue (ver esc_mlfq.c)
+  ESC_FRACAO_JUSTA, // fair share entre os terminais (ver esc_justa.c)
+  ESC_CFS,          // completely fair scheduler, pelo peso (ver esc_cfs.c)
+  ESC_N_POLITICAS
+} esc_politica_t;
+
+// política usada se nenhuma for escolhida (ver main.c)
+#define ESC_POLITICA_PADRAO ESC_MLFQ
+
+typedef struct escalonador_t escalonador_t;
+
+// cria um escalonador com a política, sem processos
+escalonador_t *esc_cria(esc_politica_t politica);
+void esc_destroi(escalonador_t *self);
+
+// retorna a política pelo nome curto ("rr", "prio", "mlfq", "justa",
+//   "cfs"), ou -1 se não existe
+int esc_politica_por_nome(char *nome);
+// nome curto de cada política, para mensagens ("rr", ...)
+char *esc_nome_politica(esc_politica_t politica);
+
+esc_politica_t esc_politica(escalonador_t *self);
+
+// o processo ficou pronto (foi criado, desbloqueado ou perdeu a CPU)
+void esc_pronto(escalonador_t *self, struct pcb *proc);
+// retira e retorna o próximo processo a executar (NULL se não tem prontos)
+struct pcb *esc_proximo(escalonador_t *self);
+// houve uma interrupção de relógio; 'corrente' é o processo em execução
+//   (NULL se nenhum). Retorna true se ele deve deixar a CPU
+bool esc_relogio(escalonador_t *self, struct pcb *corrente);
+// o processo em execução executou 'tempo' instruções desde a última vez que
+//   o SO contou o tempo (ver so_atualiza_tempos)
+void esc_executou(escalonador_t *self, struct pcb *proc, int tempo);
+// retorna true se algum processo pronto deve tomar a CPU do 'corrente'
+bool esc_preempta(escalonador_t *self, struct pcb *corrente);
+// o processo em execução bloqueou
+void esc_bloqueou(escalonador_t *self, struct pcb *proc);
+// o processo foi desbloqueado depois de esperar E/S (o SO chama esc_pronto
+//   em seguida)
+void esc_desbloqueou(escalonador_t *self, struct pcb *proc);
+// o processo terminou; se estava entre os prontos, sai
+void esc_terminou(escalonador_t *self, struct pcb *proc);
+
+// mostra os processos prontos (depuração)
+void esc_imprime(escalonador_t *self);
+// escreve a configuração da política, e os números dela, no relatório
+void esc_relatorio_configuracao(escalonador_t *self);
+void esc_relatorio(escalonador_t *self);
+
+
+// POLÍTICAS
+
+// operações de uma política; 'dados' é o que foi retornado por 'cria'
+// as operações que não interessam à política podem ser NULL (menos cria,
+//   pronto e proximo)
+typedef struct {
+  char *nome;  // nome curto, para a escolha
+  void *(*cria)(void);
+  void (*destroi)(void *dados);
+  void (*pronto)(void *dados, struct pcb *proc);
+  struct pcb *(*proximo)(void *dados);
+  bool (*relogio)(void *dados, struct pcb *corrente);
+  void (*executou)(void *dados, struct pcb *proc, int tempo);
+  bool (*preempta)(void *dados, struct pcb *corrente);
+  void (*bloqueou)(void *dados, struct pcb *proc);
+  void (*desbloqueou)(void *dados, struct pcb *proc);
+  void (*terminou)(void *dados, struct pcb *proc);
+  void (*imprime)(void *dados);
+  void (*relatorio_configuracao)(void *dados);
+  void (*relatorio)(void *dados);
+} esc_ops_t;
+
+extern esc_ops_t esc_ops_rr;
+extern esc_ops_t esc_ops_prio;
+extern esc_ops_t esc_ops_mlfq;
+extern esc_ops_t esc_ops_justa;
+extern esc_ops_t esc_ops_cfs;
+
+#endif // ESCALONADOR_H
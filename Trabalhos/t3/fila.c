@@ -1,13 +1,22 @@
 #include "fila.h"
+#include "processo.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <assert.h>
 #include "console.h"
+
 fila* cria_fila() {
     fila* f = (fila*)malloc(sizeof(fila));
+    assert(f != NULL);
+    fila_inicializa(f);
+    return f;
+}
+
+void fila_inicializa(fila* f) {
     f->tamanho = 0;
     f->inicio = NULL;
-    return f;
+    f->fim = NULL;
 }
 
 bool fila_vazia(fila* f) {
@@ -15,69 +24,60 @@ bool fila_vazia(fila* f) {
 }
 
 void destroi_fila(fila* f) {
-    fila_no* atual = f->inicio;
-    while (atual != NULL) {
-        fila_no* proximo = atual->prox;
-        free(atual);
-        atual = proximo;
+    while (!fila_vazia(f)) {
+        desenfileira(f);
     }
     free(f);
 }
 
-static fila_no* criar_no(int pid) {
-    fila_no* no = (fila_no*)malloc(sizeof(fila_no));
-    no->pid = pid;
-    no->prox = NULL;
-    return no;
-} 
-
-
-void enfileira(fila* f, int pid) { //cria um nó e insere no final da fila
-    fila_no* novo_no = criar_no(pid);
-
-    if (fila_vazia(f)) {
-        f->inicio = novo_no; // fila estava vazia, inicio aponta para o novo nó
+void enfileira(fila* f, pcb* proc) { //insere no final da fila
+    fila_retira(proc);
+    proc->fila = f;
+    proc->prox_fila = NULL;
+    proc->ant_fila = f->fim;
+    if (f->fim != NULL) {
+        f->fim->prox_fila = proc;
     } else {
-        fila_no* atual = f->inicio;
-        while (atual->prox != NULL) { //enquanto não chegar no final da fila
-            atual = atual->prox;
-        }
-        atual->prox = novo_no; //insere o novo nó no final da fila
+        f->inicio = proc; // fila estava vazia
     }
+    f->fim = proc;
     f->tamanho++;
 }
 
-int desenfileira(fila* f, int pid) { //remove o nó do início da fila
-    fila_no* atual = f->inicio;
-    if (fila_vazia(f)) {
-        return -1; // fila vazia, nada a desenfileirar
-    }
-    fila_no* anterior = NULL;
-    while (atual != NULL) {
-        if (atual->pid == pid) {
-            if (anterior == NULL) {
-                f->inicio = atual->prox; // removendo o primeiro nó da fila
-            } else {
-                anterior->prox = atual->prox; // removendo nó do meio ou fim
-            }
-            free(atual);
-            f->tamanho--;
-            return pid; // retorna o PID removido
-        }
-        anterior = atual;
-        atual = atual->prox;
-    }
-    console_printf("PID %d não encontrado na fila.\n", pid);
-    return -1; // PID não encontrado na fila
+pcb* desenfileira(fila* f) { //remove do início da fila
+    pcb* proc = f->inicio;
+    if (proc != NULL) fila_retira(proc);
+    return proc;
+}
+
+pcb* fila_primeiro(fila* f) {
+    return f->inicio;
 }
 
+void fila_retira(pcb* proc) {
+    fila* f = proc->fila;
+    if (f == NULL) return;
+    if (proc->ant_fila != NULL) proc->ant_fila->prox_fila = proc->prox_fila;
+    else f->inicio = proc->prox_fila;
+    if (proc->prox_fila != NULL) proc->prox_fila->ant_fila = proc->ant_fila;
+    else f->fim = proc->ant_fila;
+    proc->prox_fila = proc->ant_fila = NULL;
+    proc->fila = NULL;
+    f->tamanho--;
+}
+
+// mostra, em uma linha, o tamanho da fila e os pids dos primeiros
+//   FILA_MAX_IMPRESSOS processos (a fila é impressa a cada escalonamento,
+//   e pode ser grande)
+#define FILA_MAX_IMPRESSOS 16
+
 void imprime_fila(fila* f) {
-    fila_no* atual = f->inicio;
-    console_printf("Fila: ");
-    while (atual != NULL) {
-        console_printf("%d ", atual->pid);
-        atual = atual->prox;
+    char linha[FILA_MAX_IMPRESSOS * 12 + 32];
+    int n = snprintf(linha, sizeof(linha), "Fila (%d):", f->tamanho);
+    int i = 0;
+    for (pcb* atual = f->inicio; atual != NULL && i < FILA_MAX_IMPRESSOS; atual = atual->prox_fila, i++) {
+        n += snprintf(linha + n, sizeof(linha) - n, " %d", atual->pid);
     }
-    console_printf("\n");
+    if (f->tamanho > i) snprintf(linha + n, sizeof(linha) - n, " ...");
+    console_printf("%s", linha);
 }
-
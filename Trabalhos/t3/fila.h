@@ -2,22 +2,33 @@
 #define FILA_H
 #include <stdbool.h>
 
-typedef struct fila_no {
-    int pid;
-    struct fila_no* prox;
-} fila_no;
-
+// fila de processos intrusiva: os elos ficam no próprio pcb (campos
+//   prox_fila, ant_fila e fila), então enfileirar, desenfileirar e retirar
+//   um processo do meio da fila custam O(1) e não alocam memória
+// um processo está em no máximo uma fila por vez; a mesma estrutura serve
+//   para a fila de prontos e para filas de espera
+struct pcb;
 
 typedef struct fila {
     int tamanho;
-    fila_no* inicio;
+    struct pcb* inicio;
+    struct pcb* fim;
 } fila;
 
 fila* cria_fila();
+// inicializa uma fila vazia (para filas que fazem parte de outra estrutura)
+void fila_inicializa(fila* f);
 bool fila_vazia(fila* f);
+// destrói a fila; os processos que estão nela ficam sem fila
 void destroi_fila(fila* f);
-void enfileira(fila* f, int pid);
-int desenfileira(fila* f, int pid);
+// coloca o processo no fim da fila; se estava em outra fila, sai dela
+void enfileira(fila* f, struct pcb* proc);
+// retira e retorna o primeiro processo da fila (NULL se vazia)
+struct pcb* desenfileira(fila* f);
+// retorna o primeiro processo da fila, sem retirar (NULL se vazia)
+struct pcb* fila_primeiro(fila* f);
+// retira o processo da fila em que ele está (não faz nada se não está em fila)
+void fila_retira(struct pcb* proc);
 void imprime_fila(fila* f);
 
-#endif
\ No newline at end of file
+#endif
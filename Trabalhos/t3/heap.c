@@ -0,0 +1,160 @@
+// heap.c
+// heap binário de processos, ordenado por uma chave
+// simulador de computador
+// so25b
+
+#include "heap.h"
+#include "processo.h"
+#include "console.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#define HEAP_TAM_INICIAL 16
+// máximo de pids mostrados por heap_imprime
+#define HEAP_MAX_IMPRESSOS 16
+
+typedef struct {
+  double chave;
+  unsigned long ordem;  // ordem de inserção, para desempatar
+  pcb *proc;
+} heap_item_t;
+
+struct heap_t {
+  heap_item_t *itens;
+  int n;
+  int tamanho;          // número de itens alocados
+  unsigned long ordem;  // próxima ordem de inserção
+};
+
+heap_t *heap_cria(void)
+{
+  heap_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->itens = malloc(HEAP_TAM_INICIAL * sizeof(*self->itens));
+  assert(self->itens != NULL);
+  self->n = 0;
+  self->tamanho = HEAP_TAM_INICIAL;
+  self->ordem = 0;
+  return self;
+}
+
+void heap_destroi(heap_t *self)
+{
+  if (self == NULL) return;
+  for (int i = 0; i < self->n; i++) {
+    self->itens[i].proc->pos_heap = -1;
+  }
+  free(self->itens);
+  free(self);
+}
+
+bool heap_vazio(heap_t *self)
+{
+  return self->n == 0;
+}
+
+int heap_tamanho(heap_t *self)
+{
+  return self->n;
+}
+
+// retorna true se o item 'a' deve sair antes do 'b'
+static bool heap__antes(heap_item_t *a, heap_item_t *b)
+{
+  if (a->chave != b->chave) return a->chave < b->chave;
+  return a->ordem < b->ordem;
+}
+
+// coloca o item na posição, atualizando a posição no pcb
+static void heap__poe(heap_t *self, int pos, heap_item_t item)
+{
+  self->itens[pos] = item;
+  item.proc->pos_heap = pos;
+}
+
+static void heap__sobe(heap_t *self, int pos)
+{
+  heap_item_t item = self->itens[pos];
+  while (pos > 0) {
+    int pai = (pos - 1) / 2;
+    if (!heap__antes(&item, &self->itens[pai])) break;
+    heap__poe(self, pos, self->itens[pai]);
+    pos = pai;
+  }
+  heap__poe(self, pos, item);
+}
+
+static void heap__desce(heap_t *self, int pos)
+{
+  heap_item_t item = self->itens[pos];
+  for (;;) {
+    int filho = 2 * pos + 1;
+    if (filho >= self->n) break;
+    if (filho + 1 < self->n && heap__antes(&self->itens[filho + 1], &self->itens[filho])) {
+      filho++;
+    }
+    if (!heap__antes(&self->itens[filho], &item)) break;
+    heap__poe(self, pos, self->itens[filho]);
+    pos = filho;
+  }
+  heap__poe(self, pos, item);
+}
+
+void heap_insere(heap_t *self, pcb *proc, double chave)
+{
+  heap_retira(self, proc);
+  if (self->n == self->tamanho) {
+    self->tamanho *= 2;
+    self->itens = realloc(self->itens, self->tamanho * sizeof(*self->itens));
+    assert(self->itens != NULL);
+  }
+  heap_item_t item = { chave, self->ordem++, proc };
+  heap__poe(self, self->n, item);
+  self->n++;
+  heap__sobe(self, self->n - 1);
+}
+
+pcb *heap_min(heap_t *self)
+{
+  if (self->n == 0) return NULL;
+  return self->itens[0].proc;
+}
+
+double heap_chave_min(heap_t *self)
+{
+  if (self->n == 0) return 0;
+  return self->itens[0].chave;
+}
+
+pcb *heap_retira_min(heap_t *self)
+{
+  pcb *proc = heap_min(self);
+  if (proc != NULL) heap_retira(self, proc);
+  return proc;
+}
+
+void heap_retira(heap_t *self, pcb *proc)
+{
+  int pos = proc->pos_heap;
+  if (pos < 0 || pos >= self->n || self->itens[pos].proc != proc) return;
+  proc->pos_heap = -1;
+  self->n--;
+  if (pos == self->n) return;
+  // o último item vai para o lugar do retirado, e sobe ou desce
+  heap__poe(self, pos, self->itens[self->n]);
+  heap__sobe(self, pos);
+  heap__desce(self, self->itens[pos].proc->pos_heap);
+}
+
+void heap_imprime(heap_t *self)
+{
+  char linha[HEAP_MAX_IMPRESSOS * 12 + 32];
+  int n = snprintf(linha, sizeof(linha), "Heap (%d):", self->n);
+  int i;
+  for (i = 0; i < self->n && i < HEAP_MAX_IMPRESSOS; i++) {
+    n += snprintf(linha + n, sizeof(linha) - n, " %d", self->itens[i].proc->pid);
+  }
+  if (self->n > i) snprintf(linha + n, sizeof(linha) - n, " ...");
+  console_printf("%s", linha);
+}
@@ -0,0 +1,43 @@
+// heap.h
+// heap binário de processos, ordenado por uma chave
+// simulador de computador
+// so25b
+
+#ifndef HEAP_H
+#define HEAP_H
+
+// fila de prioridade para os escalonadores que escolhem o processo de menor
+//   chave (ver escalonador.h): inserir e retirar o menor custam O(log n)
+// como na fila (ver fila.h), a posição do processo fica no próprio pcb (campo
+//   pos_heap), então retirar um processo do meio também custa O(log n); um
+//   processo está em no máximo um heap por vez
+// processos com a mesma chave saem na ordem em que foram inseridos
+
+#include <stdbool.h>
+
+struct pcb;
+
+typedef struct heap_t heap_t;
+
+heap_t *heap_cria(void);
+// destrói o heap; os processos que estão nele ficam fora de heap
+void heap_destroi(heap_t *self);
+
+bool heap_vazio(heap_t *self);
+int heap_tamanho(heap_t *self);
+
+// coloca o processo no heap, com a chave
+void heap_insere(heap_t *self, struct pcb *proc, double chave);
+// retorna o processo de menor chave, sem retirar (NULL se vazio)
+struct pcb *heap_min(heap_t *self);
+// retorna a menor chave (0 se vazio)
+double heap_chave_min(heap_t *self);
+// retira e retorna o processo de menor chave (NULL se vazio)
+struct pcb *heap_retira_min(heap_t *self);
+// retira o processo do heap (não faz nada se ele não está no heap)
+void heap_retira(heap_t *self, struct pcb *proc);
+
+// mostra os pids dos processos no heap, na ordem do vetor
+void heap_imprime(heap_t *self);
+
+#endif // HEAP_H
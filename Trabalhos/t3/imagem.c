@@ -0,0 +1,127 @@
+// imagem.c
+// imagens de programas na memória secundária, compartilhadas entre processos
+// simulador de computador
+// so25b
+
+#include "imagem.h"
+#include "processo.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// são poucos programas diferentes executando ao mesmo tempo; uma lista
+//   simplesmente encadeada basta para o cache
+struct imagens_t {
+  imagem_t *primeira;
+  int n_imagens;
+};
+
+imagens_t *imagens_cria(void)
+{
+  imagens_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->primeira = NULL;
+  self->n_imagens = 0;
+  return self;
+}
+
+static void imagem_destroi(imagem_t *img)
+{
+  free(img->quadros);
+  free(img);
+}
+
+void imagens_destroi(imagens_t *self)
+{
+  if (self == NULL) return;
+  while (self->primeira != NULL) {
+    imagem_t *img = self->primeira;
+    self->primeira = img->prox;
+    imagem_destroi(img);
+  }
+  free(self);
+}
+
+// retorna true se a imagem foi carregada do arquivo com as informações 'st'
+static bool imagem_da_versao(imagem_t *img, struct stat *st)
+{
+  return img->alteracao.tv_sec == st->st_mtim.tv_sec
+      && img->alteracao.tv_nsec == st->st_mtim.tv_nsec
+      && img->tam_arq == st->st_size;
+}
+
+imagem_t *imagens_busca(imagens_t *self, char *nome, struct stat *st)
+{
+  for (imagem_t *img = self->primeira; img != NULL; img = img->prox) {
+    if (strcmp(img->nome, nome) == 0 && imagem_da_versao(img, st)) return img;
+  }
+  return NULL;
+}
+
+imagem_t *imagens_insere(imagens_t *self, char *nome, struct stat *st,
+                         int pagina_disco, int num_paginas)
+{
+  imagem_t *img = malloc(sizeof(*img));
+  assert(img != NULL);
+  strncpy(img->nome, nome, sizeof(img->nome) - 1);
+  img->nome[sizeof(img->nome) - 1] = '\0';
+  img->alteracao = st->st_mtim;
+  img->tam_arq = st->st_size;
+  img->pagina_disco = pagina_disco;
+  img->num_paginas = num_paginas;
+  img->refs = 0;
+  img->quadros = malloc(num_paginas * sizeof(*img->quadros));
+  assert(img->quadros != NULL);
+  for (int pg = 0; pg < num_paginas; pg++) {
+    img->quadros[pg] = -1;
+  }
+  img->usuarios = NULL;
+  img->prox = self->primeira;
+  self->primeira = img;
+  self->n_imagens++;
+  return img;
+}
+
+void imagens_remove(imagens_t *self, imagem_t *img)
+{
+  imagem_t **p = &self->primeira;
+  while (*p != NULL && *p != img) p = &(*p)->prox;
+  if (*p == NULL) return;
+  *p = img->prox;
+  self->n_imagens--;
+  imagem_destroi(img);
+}
+
+int imagens_num(imagens_t *self)
+{
+  return self->n_imagens;
+}
+
+void imagem_acrescenta_usuario(imagem_t *img, pcb *proc)
+{
+  proc->ant_usuario = NULL;
+  proc->prox_usuario = img->usuarios;
+  if (img->usuarios != NULL) img->usuarios->ant_usuario = proc;
+  img->usuarios = proc;
+  img->refs++;
+}
+
+void imagem_retira_usuario(imagem_t *img, pcb *proc)
+{
+  if (proc->ant_usuario != NULL) proc->ant_usuario->prox_usuario = proc->prox_usuario;
+  else img->usuarios = proc->prox_usuario;
+  if (proc->prox_usuario != NULL) proc->prox_usuario->ant_usuario = proc->ant_usuario;
+  proc->prox_usuario = proc->ant_usuario = NULL;
+  img->refs--;
+}
+
+copia_t *copia_cria(int pagina_disco)
+{
+  copia_t *copia = malloc(sizeof(*copia));
+  assert(copia != NULL);
+  copia->pagina_disco = pagina_disco;
+  copia->quadro = -1;
+  copia->suja = false;
+  copia->refs = 1;
+  return copia;
+}
@@ -0,0 +1,79 @@
+// imagem.h
+// imagens de programas na memória secundária, compartilhadas entre processos
+// simulador de computador
+// so25b
+
+#ifndef IMAGEM_H
+#define IMAGEM_H
+
+// cada programa é copiado para a memória secundária uma vez só, na primeira
+//   vez que um processo o executa; os processos seguintes que executam o mesmo
+//   programa (identificado pelo nome do executável e pela data e tamanho do
+//   arquivo) usam a mesma imagem. A imagem conta quantos processos a usam, e
+//   é liberada quando o último morre.
+// se o arquivo muda, os processos seguintes usam uma imagem nova; a antiga
+//   continua no cache, só para os processos que já a usam, até o último morrer
+// as páginas da imagem que estão na memória principal também são
+//   compartilhadas: a imagem tem o quadro de cada página, e todos os processos
+//   que a usam mapeiam esse mesmo quadro, protegido contra escrita. Na
+//   primeira escrita em uma página, o processo ganha uma cópia privada dela
+//   (cópia na escrita), com um lugar próprio na memória secundária.
+// um processo clonado (ver SO_CLONA_PROC) usa a mesma imagem e as mesmas
+//   cópias do processo original: a cópia conta quantos processos a usam, e
+//   enquanto for de mais de um, o seu quadro é compartilhado como os da
+//   imagem, até um deles escrever na página e ganhar outra cópia.
+
+#include <stdbool.h>
+#include <sys/stat.h>
+
+struct pcb;
+
+typedef struct imagem_t {
+  char nome[100];          // nome do executável
+  struct timespec alteracao; // data da última alteração do arquivo carregado
+  off_t tam_arq;           //   e o tamanho dele
+  int pagina_disco;        // primeira página da imagem na memória secundária
+  int num_paginas;         // número de páginas da imagem
+  int refs;                // número de processos usando a imagem
+  int *quadros;            // quadro com cada página (-1 se não está na memória principal)
+  struct pcb *usuarios;    // lista dos processos que usam a imagem
+  struct imagem_t *prox;   // próxima imagem do cache
+} imagem_t;
+
+typedef struct copia_t {
+  int pagina_disco;        // página da memória secundária onde a cópia é gravada
+  int quadro;              // quadro compartilhado com a cópia (-1 se não tem)
+  bool suja;               // o quadro compartilhado ainda não foi gravado
+  int refs;                // número de processos usando a cópia
+} copia_t;
+
+// cria uma cópia gravada em 'pagina_disco', usada por um processo, sem quadro
+copia_t *copia_cria(int pagina_disco);
+
+// cache de imagens, pelo nome do executável e pela versão do arquivo
+typedef struct imagens_t imagens_t;
+
+imagens_t *imagens_cria(void);
+// destrói o cache e as imagens que estão nele
+void imagens_destroi(imagens_t *self);
+// retorna a imagem do executável 'nome' carregada do arquivo com as
+//   informações 'st' (de stat), ou NULL se não tiver (uma imagem de uma
+//   versão anterior do arquivo não serve)
+imagem_t *imagens_busca(imagens_t *self, char *nome, struct stat *st);
+// cria uma imagem para 'nome', carregado do arquivo com as informações 'st',
+//   com 'num_paginas' páginas a partir de 'pagina_disco', sem nenhuma página
+//   na memória principal e sem usuários
+imagem_t *imagens_insere(imagens_t *self, char *nome, struct stat *st,
+                         int pagina_disco, int num_paginas);
+// tira a imagem do cache e a destrói
+void imagens_remove(imagens_t *self, imagem_t *img);
+// número de imagens no cache
+int imagens_num(imagens_t *self);
+
+// o processo passa a usar / deixa de usar a imagem (atualiza a lista de
+//   usuários, pelos campos prox_usuario e ant_usuario do pcb, e o contador
+//   de referências)
+void imagem_acrescenta_usuario(imagem_t *img, struct pcb *proc);
+void imagem_retira_usuario(imagem_t *img, struct pcb *proc);
+
+#endif // IMAGEM_H
@@ -3,6 +3,18 @@
 // simulador de computador
 // so25b
 
+// uso:
+//   ./main           executa com a console na tela (curses)
+//   ./main roteiro   executa sem tela, com os comandos da console lidos do
+//                    arquivo 'roteiro' (ver console_cria). A saída dos
+//                    terminais vai para os arquivos "saida_do_terminal_X" e o
+//                    relatório final das métricas para "relatorio_de_metricas"
+// a política de escalonamento é escolhida pela variável de ambiente
+//   ESCALONADOR, com o nome curto da política (rr, prio, mlfq, justa ou cfs; ver
+//   escalonador.h), por exemplo:
+//     ESCALONADOR=rr ./main roteiro
+//   sem a variável, é usada ESC_POLITICA_PADRAO
+
 #include "controle.h"
 #include "programa.h"
 #include "memoria.h"
@@ -15,12 +27,14 @@
 #include "dispositivos.h"
 #include "so.h"
 #include "metricas.h"
+#include "escalonador.h"
 #include <stdlib.h>
 #include <stdio.h>
 
 // constantes
 #define MEM_TAM 800// tamanho da memória principal
 #define MEM_SEC_TAM 10000
+#define ARQ_RELATORIO "relatorio_de_metricas" // relatório final, no modo lote
 
 // estrutura com os componentes do computador simulado
 typedef struct {
@@ -73,16 +87,14 @@ static void inicializa_rom(mem_t *mem)
     exit(1);
   }
 
-  for (int end = end_ini; end < end_fim; end++) {
-    if (mem_escreve(mem, end, prog_dado(prog, end)) != ERR_OK) {
-      printf("Erro na carga da memória ROM, endereco %d\n", end);
-      exit(1);
-    }
+  if (mem_escreve_bloco(mem, end_ini, prog_tamanho(prog), prog_dados(prog)) != ERR_OK) {
+    printf("Erro na carga da memória ROM, endereços %d-%d\n", end_ini, end_fim - 1);
+    exit(1);
   }
   prog_destroi(prog);
 }
 
-static void cria_hardware(hardware_t *hw)
+static void cria_hardware(hardware_t *hw, char *roteiro)
 {
   // cria a memória
   hw->mem = mem_cria(MEM_TAM);
@@ -93,8 +105,9 @@ static void cria_hardware(hardware_t *hw)
   hw->mmu = mmu_cria(hw->mem);
 
   // cria dispositivos de E/S
-  hw->console = console_cria();
+  hw->console = console_cria(roteiro);
   hw->relogio = relogio_cria();
+  console_define_relogio(hw->console, hw->relogio);
 
   // cria o controlador de E/S e registra os dispositivos
   //   por exemplo, o dispositivo 8 do controlador de E/S (e da CPU) será o
@@ -131,18 +144,38 @@ static void destroi_hardware(hardware_t *hw)
   mem_destroi(hw->mem_fisica);
 }
 
-int main()
+int main(int argc, char *argv[])
 {
   hardware_t hw;
   so_t *so;
 
+  if (argc > 2) {
+    fprintf(stderr, "uso: %s [roteiro]\n", argv[0]);
+    exit(1);
+  }
+  char *roteiro = (argc == 2) ? argv[1] : NULL;
+  esc_politica_t politica = ESC_POLITICA_PADRAO;
+  char *nome_politica = getenv("ESCALONADOR");
+  if (nome_politica != NULL) {
+    int p = esc_politica_por_nome(nome_politica);
+    if (p < 0) {
+      fprintf(stderr, "escalonador desconhecido '%s' (use:", nome_politica);
+      for (p = 0; p < ESC_N_POLITICAS; p++) fprintf(stderr, " %s", esc_nome_politica(p));
+      fprintf(stderr, ")\n");
+      exit(1);
+    }
+    politica = p;
+  }
+
   // cria o hardware
-  cria_hardware(&hw);
+  cria_hardware(&hw, roteiro);
   // cria o sistema operacional
-  so = so_cria(hw.cpu, hw.mem, hw.mem_fisica, hw.mmu, hw.es, hw.console);
+  so = so_cria(hw.cpu, hw.mem, hw.mem_fisica, hw.mmu, hw.es, hw.console, politica);
 
   // executa o laço principal do controlador
   controle_laco(hw.controle);
+  // sem tela, o relatório vai para um arquivo próprio
+  if (roteiro != NULL) console_redireciona_log(hw.console, ARQ_RELATORIO);
   imprimir_dados(so);
   // destroi tudo
   so_destroi(so);
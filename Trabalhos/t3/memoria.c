@@ -6,12 +6,16 @@
 #include "memoria.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 // tipo de dados para representar uma região de memória
 struct mem_t {
   int tam;
   int *conteudo;
+  // função chamada a cada escrita (ou NULL)
+  mem_aviso_escrita_t aviso_escrita;
+  void *arg_aviso;
 };
 
 
@@ -27,6 +31,11 @@ mem_t *mem_cria(int tam)
   assert(self->conteudo != NULL);
 
   self->tam = tam;
+  self->aviso_escrita = NULL;
+  self->arg_aviso = NULL;
+
+  // a memória começa com todas as posições zeradas
+  mem_zera(self, 0, tam);
 
   return self;
 }
@@ -55,6 +64,24 @@ static err_t verifica_permissao(mem_t *self, int endereco)
   return ERR_OK;
 }
 
+// função auxiliar, verifica se os 'n' endereços a partir de 'endereco' são
+//   válidos
+static err_t verifica_permissao_bloco(mem_t *self, int endereco, int n)
+{
+  if (n < 0 || endereco < 0 || endereco > self->tam - n) {
+    return ERR_END_INV;
+  }
+  return ERR_OK;
+}
+
+// função auxiliar, avisa da alteração de 'n' posições a partir de 'endereco'
+static void avisa_escrita(mem_t *self, int endereco, int n)
+{
+  if (self->aviso_escrita != NULL && n > 0) {
+    self->aviso_escrita(self->arg_aviso, endereco, n);
+  }
+}
+
 err_t mem_le(mem_t *self, int endereco, int *pvalor)
 {
   err_t err = verifica_permissao(self, endereco);
@@ -69,6 +96,60 @@ err_t mem_escreve(mem_t *self, int endereco, int valor)
   err_t err = verifica_permissao(self, endereco);
   if (err == ERR_OK) {
     self->conteudo[endereco] = valor;
+    avisa_escrita(self, endereco, 1);
+  }
+  return err;
+}
+
+err_t mem_escreve_bloco(mem_t *self, int endereco, int n, const int valores[n])
+{
+  err_t err = verifica_permissao_bloco(self, endereco, n);
+  if (err == ERR_OK) {
+    memcpy(&self->conteudo[endereco], valores, n * sizeof(*(self->conteudo)));
+    avisa_escrita(self, endereco, n);
+  }
+  return err;
+}
+
+err_t mem_copia(mem_t *destino, int end_destino, mem_t *origem, int end_origem, int n)
+{
+  err_t err = verifica_permissao_bloco(origem, end_origem, n);
+  if (err == ERR_OK) {
+    err = verifica_permissao_bloco(destino, end_destino, n);
+  }
+  if (err == ERR_OK) {
+    memmove(&destino->conteudo[end_destino], &origem->conteudo[end_origem],
+            n * sizeof(*(destino->conteudo)));
+    avisa_escrita(destino, end_destino, n);
   }
   return err;
 }
+
+err_t mem_zera(mem_t *self, int endereco, int n)
+{
+  err_t err = verifica_permissao_bloco(self, endereco, n);
+  if (err == ERR_OK) {
+    memset(&self->conteudo[endereco], 0, n * sizeof(*(self->conteudo)));
+    avisa_escrita(self, endereco, n);
+  }
+  return err;
+}
+
+err_t mem_compara(mem_t *a, int end_a, mem_t *b, int end_b, int n, bool *piguais)
+{
+  err_t err = verifica_permissao_bloco(a, end_a, n);
+  if (err == ERR_OK) {
+    err = verifica_permissao_bloco(b, end_b, n);
+  }
+  if (err == ERR_OK) {
+    *piguais = (memcmp(&a->conteudo[end_a], &b->conteudo[end_b],
+                       n * sizeof(*(a->conteudo))) == 0);
+  }
+  return err;
+}
+
+void mem_define_aviso_escrita(mem_t *self, mem_aviso_escrita_t func, void *arg)
+{
+  self->aviso_escrita = func;
+  self->arg_aviso = arg;
+}
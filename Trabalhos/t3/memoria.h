@@ -6,10 +6,16 @@
 
 // A memória é um vetor de inteiros, com um inteiro em cada posição, entre 0
 //   e tam-1 (tam é o tamanho da memória, especificado na criação).
-// Tem só 3 operações:
+// Tem 3 operações básicas:
 // - obter o tamanho da memória
 // - obter o valor do inteiro que está em uma das posições
 // - alterar o valor o inteiro que está em uma das posições
+// e operações sobre blocos de posições (para transferência de páginas e
+//   carga de programas), com a verificação de endereços feita uma só vez:
+// - escrever um vetor de valores
+// - copiar um bloco entre duas memórias (ou dentro da mesma)
+// - zerar um bloco
+// - comparar blocos de duas memórias
 //
 // O único erro possível no acesso é uma tentativa de acesso a uma posição
 //   inexistente
@@ -18,6 +24,7 @@
 #define MEMORIA_H
 
 #include "err.h"
+#include <stdbool.h>
 
 // tipo opaco que representa a memória
 typedef struct mem_t mem_t;
@@ -42,4 +49,38 @@ err_t mem_le(mem_t *self, int endereco, int *pvalor);
 // retorna erro ERR_END_INV se endereço inválido
 err_t mem_escreve(mem_t *self, int endereco, int valor);
 
+// coloca os 'n' valores de 'valores' na memória, a partir de 'endereco'
+// retorna erro ERR_END_INV (e não altera a memória) se algum endereço for
+//   inválido
+err_t mem_escreve_bloco(mem_t *self, int endereco, int n, const int valores[n]);
+
+// copia 'n' valores da memória 'origem', a partir do endereço 'end_origem',
+//   para a memória 'destino', a partir do endereço 'end_destino'
+// as memórias podem ser a mesma, e os blocos podem se sobrepor
+// retorna erro ERR_END_INV (e não altera a memória) se algum endereço for
+//   inválido, em qualquer das memórias
+err_t mem_copia(mem_t *destino, int end_destino, mem_t *origem, int end_origem, int n);
+
+// coloca 0 em 'n' posições da memória, a partir de 'endereco'
+// retorna erro ERR_END_INV (e não altera a memória) se algum endereço for
+//   inválido
+err_t mem_zera(mem_t *self, int endereco, int n);
+
+// compara 'n' valores da memória 'a', a partir de 'end_a', com os da memória
+//   'b', a partir de 'end_b'; coloca em '*piguais' se são todos iguais
+// retorna erro ERR_END_INV (e não altera '*piguais') se algum endereço for
+//   inválido
+err_t mem_compara(mem_t *a, int end_a, mem_t *b, int end_b, int n, bool *piguais);
+
+// tipo da função chamada a cada escrita bem sucedida na memória, com o
+//   endereço alterado; em escritas de blocos, é chamada uma vez, com o
+//   primeiro endereço e o número de posições alteradas
+typedef void (*mem_aviso_escrita_t)(void *arg, int endereco, int n);
+
+// define uma função a ser chamada a cada escrita na memória, e o argumento a
+//   passar para ela (usado pela CPU para saber quando uma instrução que ela
+//   já decodificou foi alterada)
+// se 'func' for NULL, as escritas não são avisadas
+void mem_define_aviso_escrita(mem_t *self, mem_aviso_escrita_t func, void *arg);
+
 #endif // MEMORIA_H
@@ -4,6 +4,7 @@
 #include "err.h"
 #include "console.h" 
 #include <stdlib.h>
+#include <assert.h>
 
 // --- Funções de gerenciamento ---
 
@@ -15,21 +16,54 @@ metricas_t* metricas_cria(void) {
   self->tempo_ocioso = 0;
   self->num_preemcoes_total = 0;
   self->tempo_ultima_atualizacao_metricas = 0;
+  self->paginas_adiantadas = 0;
+  self->adiantadas_usadas = 0;
+  self->adiantadas_desperdicadas = 0;
+  self->gravacoes_substituicao = 0;
+  self->gravacoes_limpador = 0;
+  self->imagens_carregadas = 0;
+  self->imagens_reaproveitadas = 0;
+  self->processos_clonados = 0;
+  self->paginas_compartilhadas = 0;
+  self->escritas_compartilhadas = 0;
+  self->copias_na_escrita = 0;
+  self->trocas_por_prioridade = 0;
+  self->tempo_virtual = 0;
+  self->soma_pesos = 0;
   
   for (int i = 0; i < N_IRQ; i++) {
     self->contagem_irq[i] = 0;
   }
-  for (int i = 0; i < MAX_PROCESSES; i++) {
-    self->historico_metricas[i].utilizado = false;
-    self->historico_metricas[i].pid = -1;
-  }
+  self->historico_metricas = NULL;
+  self->tam_historico = 0;
   return self;
 }
 
 void metricas_destroi(metricas_t *self) {
+  free(self->historico_metricas);
   free(self);
 }
 
+// retorna a posição do histórico do processo 'pid', aumentando o histórico
+//   se necessário (dobra de tamanho, com as posições novas não utilizadas)
+static metricas_processo_final_t *metricas_historico(metricas_t *self, int pid)
+{
+  int idx = pid - 1;
+  if (idx >= self->tam_historico) {
+    int tam = self->tam_historico > 0 ? self->tam_historico : 4;
+    while (tam <= idx) tam *= 2;
+    self->historico_metricas = realloc(self->historico_metricas,
+                                       tam * sizeof(*self->historico_metricas));
+    assert(self->historico_metricas != NULL);
+    for (int i = self->tam_historico; i < tam; i++) {
+      self->historico_metricas[i].utilizado = false;
+      self->historico_metricas[i].pid = -1;
+    }
+    self->tam_historico = tam;
+  }
+  return &self->historico_metricas[idx];
+}
+
 // --- Funções de Métricas  ---
 /*
  Retorna o tempo total de ciclos/instruções executadas no sistema.
@@ -47,8 +81,29 @@ int so_tempo_total(struct so_t *self)
     }
     return tempo_atual;
 }
+// fração justa (métrica 12): o processo passa a disputar a CPU
+static void metricas_comeca_disputa(metricas_t *m, pcb *proc)
+{
+  m->soma_pesos += proc->peso;
+  proc->v_pronto = m->tempo_virtual;
+}
+
+// fração justa: o processo deixa de disputar a CPU; o tempo que caberia a
+//   ele enquanto disputava é o peso vezes o avanço do tempo virtual
+static void metricas_termina_disputa(metricas_t *m, pcb *proc)
+{
+  proc->tempo_devido += proc->peso * (m->tempo_virtual - proc->v_pronto);
+  m->soma_pesos -= proc->peso;
+}
+
+static bool estado_disputa_cpu(estado_processo estado)
+{
+  return estado == P_PRONTO || estado == P_EXECUTANDO;
+}
+
 //função auxiliar para inicializar métricas da pcb
-void inicializa_metricas_pcb(pcb *proc, int tempo_atual)
+// o processo é criado pronto, e já passa a disputar a CPU (métrica 12)
+void inicializa_metricas_pcb(struct so_t *self, pcb *proc, int tempo_atual)
 {
   // métricas 6, 7, 8, 9, 10
   proc->tempo_criacao = tempo_atual;
@@ -64,6 +119,9 @@ void inicializa_metricas_pcb(pcb *proc, int tempo_atual)
     proc->contagem_estados[i] = 0;
     proc->tempo_em_estado[i] = 0;
   }
+  // métrica 12
+  proc->tempo_devido = 0;
+  metricas_comeca_disputa(so_get_metricas(self), proc);
 }
 //Função para centralizar a mudança de estado e contabilizar (Métricas 8 e 9)
 void so_muda_estado(struct so_t *self, pcb *proc, estado_processo novo_estado)
@@ -100,16 +158,40 @@ void so_muda_estado(struct so_t *self, pcb *proc, estado_processo novo_estado)
     proc->num_respostas_pos_bloqueio++; // conta o evento agora
     proc->tempo_desbloqueou = -1; // limpa flag
   }
+
+  // --- Métrica 12: fração justa ---
+  // o tempo de CPU que caberia a cada processo se ela fosse dividida entre
+  //   os que a disputam (prontos ou executando) na proporção dos pesos
+  //   (generalized processor sharing). Em vez de dividir cada intervalo
+  //   entre todos, um tempo virtual avança 1/soma_pesos por instrução (ver
+  //   so_atualiza_tempos), e cada processo calcula o que lhe cabe só quando
+  //   entra e sai da disputa: O(1) por mudança de estado
+  bool disputava = estado_disputa_cpu(estado_anterior);
+  bool disputa = estado_disputa_cpu(novo_estado);
+  metricas_t *m = so_get_metricas(self);
+  if (!disputava && disputa) metricas_comeca_disputa(m, proc);
+  else if (disputava && !disputa) metricas_termina_disputa(m, proc);
+}
+
+void so_muda_peso(struct so_t *self, pcb *proc, int peso)
+{
+  metricas_t *m = so_get_metricas(self);
+  bool disputa = estado_disputa_cpu(proc->estado);
+  if (disputa) metricas_termina_disputa(m, proc);
+  proc->peso = peso;
+  if (disputa) metricas_comeca_disputa(m, proc);
 }
 
-//atualiza o tempo ocioso e o tempo em estado dos processos (Métricas 3 e 9)
+//atualiza o tempo ocioso e o tempo em estado do processo em execução (Métricas 3 e 9)
 //deve ser chamada NO INICIO de so trata interrupcao
+// o tempo dos processos prontos e bloqueados não é atualizado aqui: ele é
+//   contado de uma vez quando o processo muda de estado (ver so_muda_estado),
+//   então o custo não depende de quantos processos existem
 void so_atualiza_tempos(struct so_t *self)
 {
     int tempo_atual = so_tempo_total(self);
     // usar GETTERS para acessar os dados
     metricas_t *m = so_get_metricas(self); 
-    pcb **tabela_processos = so_get_tabela_de_processos(self);
     int processo_corrente = so_get_processo_corrente(self);
     int delta_t = tempo_atual - m->tempo_ultima_atualizacao_metricas;
 
@@ -118,6 +200,11 @@ void so_atualiza_tempos(struct so_t *self)
     if (delta_t == 0)
         return;
 
+    // métrica 12: o tempo virtual avança enquanto há processos disputando a CPU
+    if (m->soma_pesos > 0) {
+        m->tempo_virtual += (double)delta_t / m->soma_pesos;
+    }
+
     if (processo_corrente == NO_PROCESS){
         // METRICA 3: Sistema estava ocioso
         //self->tempo_ocioso += delta_t;
@@ -125,23 +212,15 @@ void so_atualiza_tempos(struct so_t *self)
     }
     else{
         // metrica 9: Atualiza tempo do processo que estava executando
-        pcb *proc = tabela_processos[processo_corrente];
+        pcb *proc = tabproc_processo(so_get_tabela_de_processos(self), processo_corrente);
         if (proc != NULL && proc->estado == P_EXECUTANDO){
         proc->tempo_em_estado[P_EXECUTANDO] += delta_t;
         proc->tempo_ultima_mudanca_estado = tempo_atual;
+        // o escalonador também conta o tempo de CPU (ver esc_executou)
+        esc_executou(so_get_escalonador(self), proc, delta_t);
         }
     }
 
-    // Métrica 9: Atualiza tempo de processos prontos ou bloqueados
-    for (int i = 0; i < MAX_PROCESSES; i++){
-        pcb *p = tabela_processos[i];
-        if (p != NULL && i != processo_corrente){
-        if (p->estado == P_PRONTO || p->estado == P_BLOQUEADO){
-            p->tempo_em_estado[p->estado] += delta_t;
-            p->tempo_ultima_mudanca_estado = tempo_atual;
-        }
-        }
-    }
     m->tempo_ultima_atualizacao_metricas = tempo_atual;
 }
 //função chamada IMEDIATAMENTE ANTES de dar free() em um PCB, para salvar as métricas finais
@@ -152,9 +231,7 @@ void so_salva_metricas_finais(struct so_t *self, pcb *proc)
     return;
   // acha um slot no histórico.
   // usaremos o (pid - 1) como índice (assume que PID começa em 1)
-  int idx = proc->pid - 1;
-
-  if (idx < 0 || idx >= MAX_PROCESSES)
+  if (proc->pid < 1)
   {
     console_printf("SO: ERRO DE MÉTRICA: PID %d fora do limite do histórico!", proc->pid);
     return;
@@ -174,7 +251,7 @@ void so_salva_metricas_finais(struct so_t *self, pcb *proc)
   proc->tempo_em_estado[proc->estado] += delta_t;
 
   // Copia os dados para o histórico
-  metricas_processo_final_t *hist = &m->historico_metricas[idx];
+  metricas_processo_final_t *hist = metricas_historico(m, proc->pid);
 
   hist->utilizado = true;
   hist->pid = proc->pid;
@@ -184,6 +261,8 @@ void so_salva_metricas_finais(struct so_t *self, pcb *proc)
   hist->tempo_total_resposta_pos_bloqueio = proc->tempo_total_resposta_pos_bloqueio;
   hist->num_respostas_pos_bloqueio = proc->num_respostas_pos_bloqueio;
   hist->total_page_faults = proc->page_faults;
+  hist->peso = proc->peso;
+  hist->tempo_devido = proc->tempo_devido;
   for (int i = 0; i < P_N_ESTADOS; i++)
   {
     hist->contagem_estados[i] = proc->contagem_estados[i];
@@ -214,29 +293,28 @@ void imprimir_dados(struct so_t *self)
   // Atualiza uma última vez os tempos antes de imprimir
   so_atualiza_tempos(self);
   metricas_t *m = so_get_metricas(self);
-  pcb **tabela_processos = so_get_tabela_de_processos(self);
-  // garante que o tempo do último processo a terminar seja contabilizado
-  for (int i = 0; i < MAX_PROCESSES; i++)
-  {
-    pcb *p = tabela_processos[i];
-    if (p != NULL && p->estado != P_TERMINOU)
-    {
-      int tempo_atual = so_tempo_total(self);
-      int delta_t = tempo_atual - p->tempo_ultima_mudanca_estado;
-      p->tempo_em_estado[p->estado] += delta_t;
-    }
-  }
+  tabproc_t *tabela_processos = so_get_tabela_de_processos(self);
+  // o tempo de quem ainda não terminou é contabilizado quando ele passa
+  //   para TERMINOU, abaixo
   
   console_printf("\n ===== RELATÓRIO DE MÉTRICAS DO SISTEMA =====");
   console_printf("Configurações do Sistema Operacional:");
-  console_printf(" - Política de Escalonamento: round robin");
-  console_printf(" - Quantum: %d", QUANTUM);
+  // a política descreve a si mesma (ver escalonador.h)
+  esc_relatorio_configuracao(so_get_escalonador(self));
   console_printf(" - Numero de interrupções: %d", so_get_intervalo_interrupcao(self));
-  int a = so_get_algoritmo_substituicao(self);
-  if(a==0){
+  switch (so_get_algoritmo_substituicao(self)) {
+  case ALG_FIFO:
     console_printf(" - Algoritmo de substituição de páginas: FIFO");
-  }else{
+    break;
+  case ALG_LRU:
     console_printf(" - Algoritmo de substituição de páginas: LRU");
+    break;
+  case ALG_RELOGIO:
+    console_printf(" - Algoritmo de substituição de páginas: CLOCK (segunda chance)");
+    break;
+  case ALG_RELOGIO_MELHORADO:
+    console_printf(" - Algoritmo de substituição de páginas: CLOCK melhorado (segunda chance, preferindo páginas não alteradas)");
+    break;
   }
   
   console_printf(" - Tamanho da memória física: %d quadros", so_get_tamanho_memoria_fisica(self));
@@ -245,6 +323,8 @@ void imprimir_dados(struct so_t *self)
 
   // Métrica 1: Número de processos criados
   console_printf("1. Número total de processos criados: %d", m->num_proc_criados);
+  console_printf("   Tabela de processos: %d posições, até %d processos ao mesmo tempo",
+  tabproc_tamanho(tabela_processos), tabproc_max_num(tabela_processos));
 
   // Métrica 2: Tempo total de execução
   int tempo_total = so_tempo_total(self);
@@ -266,15 +346,61 @@ void imprimir_dados(struct so_t *self)
 
   // Métrica 5: Número de preempções
   console_printf("5. Número total de preempções (troca por quantum): %d", m->num_preemcoes_total );
+  console_printf("   Trocas por prioridade (um processo mais prioritário tomou a CPU): %d", m->trocas_por_prioridade);
+  esc_relatorio(so_get_escalonador(self));
+
+  // TLB da MMU: traduções encontradas e não encontradas
+  mmu_t *mmu = so_get_mmu(self);
+  long acertos_tlb = mmu_acertos_tlb(mmu);
+  long falhas_tlb = mmu_falhas_tlb(mmu);
+  long acessos_tlb = acertos_tlb + falhas_tlb;
+  console_printf("   TLB (%d entradas): %ld acertos, %ld falhas (%.2f%% de acerto)",
+  TAM_TLB, acertos_tlb, falhas_tlb,
+  acessos_tlb > 0 ? (double)acertos_tlb / acessos_tlb * 100.0 : 0.0);
+
+  // leitura adiantada: quantas das páginas lidas antes da falta foram usadas
+  console_printf("   Leitura adiantada (até %d páginas): %d lidas, %d usadas, %d desperdiçadas (%.2f%% de acerto)",
+  MAX_LEITURA_ADIANTADA, m->paginas_adiantadas, m->adiantadas_usadas, m->adiantadas_desperdicadas,
+  m->paginas_adiantadas > 0 ? (double)m->adiantadas_usadas / m->paginas_adiantadas * 100.0 : 0.0);
+
+  // páginas alteradas: gravadas na hora da substituição ou antes, pelo limpador
+  console_printf("   Páginas alteradas gravadas no disco: %d na substituição, %d pelo limpador",
+  m->gravacoes_substituicao, m->gravacoes_limpador);
+
+  // imagens compartilhadas: programas carregados uma vez para vários processos
+  console_printf("   Imagens de programas: %d carregadas, %d reaproveitadas por outro processo, %d clones",
+  m->imagens_carregadas, m->imagens_reaproveitadas, m->processos_clonados);
+  console_printf("   Páginas compartilhadas: %d faltas sem disco, %d escritas (%d com cópia do quadro)",
+  m->paginas_compartilhadas, m->escritas_compartilhadas, m->copias_na_escrita);
+
+  // programas carregados a partir do cache, sem ler o arquivo
+  programas_t *programas = so_get_programas(self);
+  console_printf("   Arquivos de programas: %d lidos, %d cargas sem leitura (cache)",
+  programas_leituras(programas), programas_acertos(programas));
+
+  // memória secundária: uso e fragmentação (quanto do espaço livre não está
+  //   no maior trecho livre, e não pode ser usado por um processo grande)
+  mapa_disco_t *disco = so_get_mapa_disco(self);
+  int n_trechos, maior_trecho;
+  mapa_disco_trechos_livres(disco, &n_trechos, &maior_trecho);
+  int paginas_disco = mapa_disco_num_paginas(disco);
+  int livres_disco = paginas_disco - mapa_disco_num_ocupadas(disco);
+  console_printf("   Memória secundária (%d páginas): %d em uso (máximo %d, %.2f%%), %d alocações falharam",
+  paginas_disco, mapa_disco_num_ocupadas(disco), mapa_disco_max_ocupadas(disco),
+  paginas_disco > 0 ? (double)mapa_disco_max_ocupadas(disco) / paginas_disco * 100.0 : 0.0,
+  mapa_disco_num_falhas(disco));
+  console_printf("   Trechos livres: %d, maior com %d páginas (fragmentação %.2f%%)",
+  n_trechos, maior_trecho,
+  livres_disco > 0 ? (double)(livres_disco - maior_trecho) / livres_disco * 100.0 : 0.0);
 
   console_printf("\n--- MÉTRICAS POR PROCESSO ---");
   // Antes de imprimir, faz uma última varredura na tabela de processos
   // para salvar as métricas de quem ainda não foi liberado (ex: o próprio init
   // ou outros processos que sobraram)
   int tempo_final = so_tempo_total(self);
-  for (int i = 0; i < MAX_PROCESSES; i++)
+  for (int i = 0; i < tabproc_tamanho(tabela_processos); i++)
   {
-    pcb *p = tabela_processos[i];
+    pcb *p = tabproc_processo(tabela_processos, i);
     if (p != NULL)
     {
       //se o processo estava rodando ou pronto, seu "término" é agora
@@ -289,8 +415,9 @@ void imprimir_dados(struct so_t *self)
   }
 
   // imprime TUDO o que está no histórico
-  // self->num_proc_criados tem o número total de processos que já existiram
-  for (int i = 0; i < m->num_proc_criados; i++){
+  double soma_erros = 0;  // soma dos erros de fração justa (em módulo)
+  int n_erros = 0;
+  for (int i = 0; i < m->tam_historico; i++){
     //pega a métrica salva do histórico (índice i == pid i+1)
     metricas_processo_final_t *p = &m->historico_metricas[i];
 
@@ -342,5 +469,26 @@ void imprimir_dados(struct so_t *self)
     }
 
     console_printf("11. Número total de page faults: %d", p->total_page_faults);
+
+    // Métrica 12: fração justa
+    int executou = p->tempo_em_estado[P_EXECUTANDO];
+    if (p->tempo_devido >= 1)
+    {
+      double erro = (executou - p->tempo_devido) / p->tempo_devido * 100.0;
+      console_printf("12. Fração justa (peso %d): executou %d ciclos, o peso daria %.0f (erro %+.2f%%)",
+      p->peso, executou, p->tempo_devido, erro);
+      soma_erros += erro < 0 ? -erro : erro;
+      n_erros++;
+    }
+    else
+    {
+      console_printf("12. Fração justa (peso %d): N/A (não disputou a CPU)", p->peso);
+    }
+  }
+
+  if (n_erros > 0)
+  {
+    console_printf("\nErro médio de fração justa: %.2f%% (média dos erros da métrica 12, em módulo)",
+    soma_erros / n_erros);
   }
 }
\ No newline at end of file
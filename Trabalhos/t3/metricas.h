@@ -2,7 +2,7 @@
 #pragma once
 
 #include "irq.h"       // Para N_IRQ
-#include "processo.h"  // Para metricas_processo_final_t e MAX_PROCESSES
+#include "processo.h"  // Para metricas_processo_final_t
 
 // AGRUPAR todos os campos de métrica
 typedef struct metricas_t {
@@ -11,7 +11,30 @@ typedef struct metricas_t {
   int contagem_irq[N_IRQ];
   int num_preemcoes_total;
   int tempo_ultima_atualizacao_metricas;
-  metricas_processo_final_t historico_metricas[MAX_PROCESSES];
+  // leitura adiantada de páginas
+  int paginas_adiantadas;       // páginas lidas adiantadas
+  int adiantadas_usadas;        // delas, as que foram usadas (acertos)
+  int adiantadas_desperdicadas; // e as substituídas ou descartadas sem uso
+  // páginas alteradas gravadas no disco
+  int gravacoes_substituicao;   // na substituição, atrasando a falta de página
+  int gravacoes_limpador;       // pelo limpador, com o disco ocioso
+  // imagens de programas compartilhadas entre processos
+  int imagens_carregadas;       // programas copiados para a memória secundária
+  int imagens_reaproveitadas;   // processos criados com uma imagem já carregada
+  int processos_clonados;       // processos criados por SO_CLONA_PROC
+  int paginas_compartilhadas;   // faltas resolvidas com o quadro de outro processo
+  int escritas_compartilhadas;  // primeiras escritas em páginas compartilhadas
+  int copias_na_escrita;        // delas, as que precisaram copiar o quadro
+  int trocas_por_prioridade;    // processos que perderam a CPU para um mais prioritário
+  // fração justa (métrica 12): o tempo virtual avança 1/soma_pesos a cada
+  //   instrução em que há processos prontos ou executando; soma_pesos é a
+  //   soma dos pesos deles (ver so_muda_estado)
+  double tempo_virtual;
+  int soma_pesos;
+  // histórico dos processos que terminaram, na posição pid-1; os pids não
+  //   são reaproveitados, e o vetor cresce conforme eles aumentam
+  metricas_processo_final_t *historico_metricas;
+  int tam_historico;
 } metricas_t;
 
 // PROTÓTIPOS DAS FUNÇÕES DE MÉTRICAS 
@@ -27,8 +50,10 @@ void metricas_destroi(metricas_t *self);
 
 // Funções de métricas que você quer mover
 int so_tempo_total(struct so_t *self);
-void inicializa_metricas_pcb(pcb *proc, int tempo_atual);
+void inicializa_metricas_pcb(struct so_t *self, pcb *proc, int tempo_atual);
 void so_muda_estado(struct so_t *self, pcb *proc, estado_processo novo_estado);
+// muda o peso do processo, contabilizando a fração justa com o peso antigo
+void so_muda_peso(struct so_t *self, pcb *proc, int peso);
 void so_atualiza_tempos(struct so_t *self);
 void so_salva_metricas_finais(struct so_t *self, pcb *proc);
 const char *estado_nome(estado_processo estado);
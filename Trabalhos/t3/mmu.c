@@ -8,12 +8,28 @@
 #include <stdlib.h>
 #include <assert.h>
 
+// uma entrada da TLB: tradução de uma página de uma tabela de páginas
+typedef struct {
+  // tabela de páginas a que a tradução pertence (NULL se entrada vazia)
+  tabpag_t *tabpag;
+  int pagina;
+  int quadro;
+  // o bit de alteração já foi marcado na tabela
+  bool alterada;
+  // permissões de acesso à página (TABPAG_LEITURA etc)
+  int permissao;
+} entrada_tlb_t;
+
 // tipo de dados opaco para representar uma MMU
 struct mmu_t {
   // memória física
   mem_t *mem;
   // tabela de páginas
   tabpag_t *tabpag;
+  // TLB, com as últimas traduções feitas
+  entrada_tlb_t tlb[TAM_TLB];
+  long acertos_tlb;
+  long falhas_tlb;
 };
 
 mmu_t *mmu_cria(mem_t *mem)
@@ -23,6 +39,11 @@ mmu_t *mmu_cria(mem_t *mem)
   assert(self != NULL);
   self->mem = mem;
   self->tabpag = NULL;
+  for (int i = 0; i < TAM_TLB; i++) {
+    self->tlb[i].tabpag = NULL;
+  }
+  self->acertos_tlb = 0;
+  self->falhas_tlb = 0;
   return self;
 }
 
@@ -34,27 +55,110 @@ void mmu_destroi(mmu_t *self)
   }
 }
 
+mem_t *mmu_mem(mmu_t *self)
+{
+  return self->mem;
+}
+
 void mmu_define_tabpag(mmu_t *self, tabpag_t *tabpag)
 {
   self->tabpag = tabpag;
 }
 
+// retorna a entrada da TLB onde pode estar a tradução de 'pagina' de 'tabpag'
+// a tabela entra no cálculo, pelo asid, para que processos diferentes não
+//   disputem sempre as mesmas entradas; o endereço da tabela não é usado
+//   para que os acertos e falhas na TLB dependam só do que é simulado
+// as páginas de cada tabela começam MMU_PASSO_ASID entradas depois das da
+//   tabela anterior (os processos costumam ter poucas páginas)
+#define MMU_PASSO_ASID 8
+static entrada_tlb_t *mmu__entrada_tlb(mmu_t *self, tabpag_t *tabpag, int pagina)
+{
+  unsigned h = (unsigned)tabpag_asid(tabpag) * MMU_PASSO_ASID;
+  return &self->tlb[(h + (unsigned)pagina) % TAM_TLB];
+}
+
+void mmu_invalida_pagina(mmu_t *self, tabpag_t *tabpag, int pagina)
+{
+  entrada_tlb_t *ent = mmu__entrada_tlb(self, tabpag, pagina);
+  if (ent->tabpag == tabpag && ent->pagina == pagina) {
+    ent->tabpag = NULL;
+  }
+}
+
+void mmu_invalida_tabpag(mmu_t *self, tabpag_t *tabpag)
+{
+  for (int i = 0; i < TAM_TLB; i++) {
+    if (self->tlb[i].tabpag == tabpag) {
+      self->tlb[i].tabpag = NULL;
+    }
+  }
+}
+
+long mmu_acertos_tlb(mmu_t *self)
+{
+  return self->acertos_tlb;
+}
+
+long mmu_falhas_tlb(mmu_t *self)
+{
+  return self->falhas_tlb;
+}
+
 // traduz o endereço virtual 'endvirt', colocando o endereço físico
 //   correspondente em 'pendfis'.
-// retorna ERR_OK ou um erro se a tradução não for possível
-static err_t mmu__traduz(mmu_t *self, int endvirt, int *pendfis)
+// 'acesso' é o tipo de acesso (TABPAG_LEITURA, TABPAG_ESCRITA ou
+//   TABPAG_EXECUCAO), que deve ser permitido para a página
+// marca a página como acessada (e alterada, se for escrita)
+// a tradução é procurada na TLB; se não estiver lá, é feita pela tabela de
+//   páginas e colocada na TLB, substituindo a que estiver na entrada
+// os bits na tabela não são atualizados a cada acesso nem quando a entrada
+//   sai da TLB: o de acesso é marcado quando a tradução entra na TLB, e o de
+//   alteração na primeira escrita com ela na TLB (a entrada lembra que já
+//   marcou). Assim a tabela está sempre em dia, e retirar uma entrada da TLB
+//   (substituição ou invalidação) não precisa escrever nada na tabela
+// retorna ERR_OK ou um erro se a tradução não for possível, ou
+//   ERR_PAG_PROTEGIDA se o acesso não for permitido
+static err_t mmu__traduz(mmu_t *self, int endvirt, int *pendfis, int acesso)
 {
   int pagina = endvirt / TAM_PAGINA;
   int deslocamento = endvirt % TAM_PAGINA;
-  int quadro;
-  err_t err = tabpag_traduz(self->tabpag, pagina, &quadro);
-  if (err == ERR_OK) {
-    *pendfis = quadro * TAM_PAGINA + deslocamento;
+  entrada_tlb_t *ent = mmu__entrada_tlb(self, self->tabpag, pagina);
+  if (ent->tabpag == self->tabpag && ent->pagina == pagina) {
+    self->acertos_tlb++;
+  } else {
+    self->falhas_tlb++;
+    int quadro;
+    err_t err = tabpag_traduz(self->tabpag, pagina, &quadro);
+    if (err != ERR_OK) return err;
+    ent->tabpag = self->tabpag;
+    ent->pagina = pagina;
+    ent->quadro = quadro;
+    ent->alterada = false;
+    ent->permissao = tabpag_permissao(self->tabpag, pagina);
+    tabpag_marca_bit_acesso(self->tabpag, pagina, false);
   }
-  return err;
+  if ((ent->permissao & acesso) == 0) return ERR_PAG_PROTEGIDA;
+  if (acesso == TABPAG_ESCRITA && !ent->alterada) {
+    tabpag_marca_bit_acesso(self->tabpag, pagina, true);
+    ent->alterada = true;
+  }
+  *pendfis = ent->quadro * TAM_PAGINA + deslocamento;
+  return ERR_OK;
 }
 
-err_t mmu_le(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo)
+err_t mmu_traduz(mmu_t *self, int endvirt, int *pendfis, cpu_modo_t modo)
+{
+  if (modo == supervisor || self->tabpag == NULL) {
+    *pendfis = endvirt;
+    return ERR_OK;
+  }
+  return mmu__traduz(self, endvirt, pendfis, TABPAG_EXECUCAO);
+}
+
+// lê o valor em 'endvirt', com um acesso do tipo 'acesso'
+static err_t mmu__le(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo,
+                     int acesso)
 {
   // em modo supervisor ou se não tiver tabela de páginas,
   //   não faz tradução de endereços, nem marca o acesso
@@ -62,16 +166,23 @@ err_t mmu_le(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo)
     return mem_le(self->mem, endvirt, pvalor);
   }
   int endfis;
-  err_t err = mmu__traduz(self, endvirt, &endfis);
+  err_t err = mmu__traduz(self, endvirt, &endfis, acesso);
   if (err == ERR_OK) {
     err = mem_le(self->mem, endfis, pvalor);
-    if (err == ERR_OK) {
-      tabpag_marca_bit_acesso(self->tabpag, endvirt / TAM_PAGINA, false);
-    }
   }
   return err;
 }
 
+err_t mmu_le(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo)
+{
+  return mmu__le(self, endvirt, pvalor, modo, TABPAG_LEITURA);
+}
+
+err_t mmu_busca(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo)
+{
+  return mmu__le(self, endvirt, pvalor, modo, TABPAG_EXECUCAO);
+}
+
 err_t mmu_escreve(mmu_t *self, int endvirt, int valor, cpu_modo_t modo)
 {
   // em modo supervisor ou se não tiver tabela de páginas,
@@ -80,12 +191,9 @@ err_t mmu_escreve(mmu_t *self, int endvirt, int valor, cpu_modo_t modo)
     return mem_escreve(self->mem, endvirt, valor);
   }
   int endfis;
-  err_t err = mmu__traduz(self, endvirt, &endfis);
+  err_t err = mmu__traduz(self, endvirt, &endfis, TABPAG_ESCRITA);
   if (err == ERR_OK) {
     err = mem_escreve(self->mem, endfis, valor);
-    if (err == ERR_OK) {
-      tabpag_marca_bit_acesso(self->tabpag, endvirt / TAM_PAGINA, true);
-    }
   }
   return err;
 }
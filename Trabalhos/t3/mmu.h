@@ -23,6 +23,10 @@ typedef struct mmu_t mmu_t;
 // t3: pode ser alterado para comparar configurações diferentes
 #define TAM_PAGINA 5
 
+// número de entradas na TLB da MMU (mapeamento direto)
+// t3: pode ser alterado para comparar configurações diferentes
+#define TAM_TLB 32
+
 // cria uma MMU para gerenciar acessos à memória
 // retorna um ponteiro para um descritor, que deverá ser usado em todas
 //   as operações nessa MMU
@@ -34,28 +38,67 @@ mmu_t *mmu_cria(mem_t *mem);
 // nenhuma outra operação pode ser realizada na MMU após esta chamada
 void mmu_destroi(mmu_t *self);
 
+// retorna a memória física gerenciada pela MMU
+mem_t *mmu_mem(mmu_t *self);
+
 // define a tabela de páginas a usar nas próximas traduções
 // se tabpag for NULL, os acessos serão repassados à memória sem alteração
+// as entradas da TLB são identificadas pela tabela de páginas a que
+//   pertencem, então a troca de tabela não esvazia a TLB
 void mmu_define_tabpag(mmu_t *self, tabpag_t *tabpag);
 
+// a TLB guarda traduções de 'tabpag' e o estado dos bits de acesso e
+//   alteração já marcados na tabela: o bit de acesso é marcado quando a
+//   tradução entra na TLB e o de alteração na primeira escrita na página
+// quem alterar a tabela de páginas (mudar ou invalidar uma página, zerar o
+//   bit de acesso, mudar as permissões) ou destruí-la deve avisar a MMU, com as funções abaixo,
+//   para que as entradas correspondentes sejam retiradas da TLB
+
+// retira da TLB a tradução da página 'pagina' da tabela 'tabpag'
+void mmu_invalida_pagina(mmu_t *self, tabpag_t *tabpag, int pagina);
+
+// retira da TLB todas as traduções da tabela 'tabpag'
+void mmu_invalida_tabpag(mmu_t *self, tabpag_t *tabpag);
+
+// retorna o número de traduções encontradas na TLB (acertos) e não
+//   encontradas (falhas, que precisaram consultar a tabela de páginas)
+long mmu_acertos_tlb(mmu_t *self);
+long mmu_falhas_tlb(mmu_t *self);
+
 // coloca na posição apontada por 'pvalor' o valor que está na memória
 //   no endereço físico correspondente ao endereço virtual 'endvirt'
 // marca a página como acessada se o acesso for bem sucedido
 // retorna erro se acesso não for possível, por um erro de tradução
-//   (ver tabpag_traduz) ou de memória (ver mem_le)
+//   (ver tabpag_traduz) ou de memória (ver mem_le), ou ERR_PAG_PROTEGIDA
+//   se a página não puder ser lida (ver tabpag_define_permissao)
 // se o acesso for feito em modo supervisor, ou se a mmu não tiver tabela de
 //   página definida, trata 'endvirt' como endereço físico: repassa o acesso
 //   à memória sem tradução
 err_t mmu_le(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo);
 
+// como mmu_le, mas para a busca de uma instrução (ou de seu argumento): a
+//   página precisa ter permissão de execução em vez de leitura
+err_t mmu_busca(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo);
+
 // coloca 'valor' no endereço físico da memória correspondente ao endereço
 //   virtual 'endvirt'
 // marca a página como acessada e alterada se o acesso for bem sucedido
 // retorna erro se acesso não for possível, por um erro de tradução
-//   (ver tabpag_traduz) ou de memória (ver mem_escreve)
+//   (ver tabpag_traduz) ou de memória (ver mem_escreve), ou ERR_PAG_PROTEGIDA
+//   se a página não puder ser escrita (ver tabpag_define_permissao)
 // se o acesso for feito em modo supervisor, ou se a mmu não tiver tabela de
 //   página definida, trata 'endvirt' como endereço físico: repassa o acesso
 //   à memória sem tradução
 err_t mmu_escreve(mmu_t *self, int endvirt, int valor, cpu_modo_t modo);
 
+// coloca em 'pendfis' o endereço físico correspondente a 'endvirt', sem
+//   acessar a memória
+// marca a página como acessada, como se fosse feita uma busca de instrução
+//   (usado pela CPU para buscar instruções que ela já decodificou)
+// retorna erro se a tradução não for possível (ver tabpag_traduz), ou
+//   ERR_PAG_PROTEGIDA se a página não tiver permissão de execução
+// se o acesso for feito em modo supervisor, ou se a mmu não tiver tabela de
+//   página definida, o endereço físico é o próprio 'endvirt'
+err_t mmu_traduz(mmu_t *self, int endvirt, int *pendfis, cpu_modo_t modo);
+
 #endif // MMU_H
@@ -8,6 +8,7 @@
 // ---------------------------------------------------------------------
 
 #include "instrucao.h"
+#include "programa.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -55,6 +56,7 @@ int mem_min = -1;       // menor endereço preenchido
 int mem_max = -1;       // maior endereço preenchido
 
 char *nome_fonte;   // nome do arquivo fonte a montar
+bool saida_binaria = false;  // gera o .maq no formato binário (ver programa.h)
 
 // coloca um valor no final da memória
 void mem_insere(int val)
@@ -89,6 +91,25 @@ void mem_imprime(void)
   }
 }
 
+// escreve uma palavra na saída, em little-endian
+void palavra_imprime(int val)
+{
+  unsigned int v = val;
+  unsigned char b[4] = { v & 0xff, (v >> 8) & 0xff, (v >> 16) & 0xff, (v >> 24) & 0xff };
+  fwrite(b, 1, sizeof(b), stdout);
+}
+
+// escreve o conteúdo da memória no formato binário
+void mem_imprime_binario(void)
+{
+  palavra_imprime(PROG_MAGICO);
+  palavra_imprime(mem_max - mem_min + 1);
+  palavra_imprime(mem_min);
+  for (int i = mem_min; i <= mem_max; i++) {
+    palavra_imprime(mem[i]);
+  }
+}
+
 
 // ---------------------------------------------------------------------
 // SÍMBOLOS {{{1
@@ -408,12 +429,14 @@ void verifica_args(int argc, char *argv[argc])
         fprintf(stderr, "ERRO: endereço inválido: '%s'\n", argv[argi]);
         exit(1);
       }
+    } else if (strcmp(argv[argi], "-b") == 0) {
+      saida_binaria = true;
     } else {
       nome_fonte = argv[argi];
     }
   }
   if (nome_fonte == NULL) {
-    fprintf(stderr, "ERRO: chame como '%s [-e end.inicial] nome_do_arquivo'\n",
+    fprintf(stderr, "ERRO: chame como '%s [-b] [-e end.inicial] nome_do_arquivo'\n",
             argv[0]);
     exit(1);
   }
@@ -423,7 +446,11 @@ int main(int argc, char *argv[argc])
 {
   verifica_args(argc, argv);
   monta_arquivo(nome_fonte);
-  mem_imprime();
+  if (saida_binaria) {
+    mem_imprime_binario();
+  } else {
+    mem_imprime();
+  }
   return 0;
 }
 
@@ -0,0 +1,92 @@
+; programa de exemplo para SO
+; carga com muitos processos ao mesmo tempo, para a tabela de processos
+; clona a si mesmo N vezes (ver SO_CLONA_PROC); cada clone gasta um pouco de
+;   CPU e morre. O processo original morre depois de criar todos, sem
+;   esperar por eles
+; os clones não escrevem na memória (não usam 'chama', que guarda o endereço
+;   de retorno na memória, nem 'armm'), para que as páginas fiquem
+;   compartilhadas e nenhum clone faça cópia de página; o original conta os
+;   clones em registrador, e só escreve na memória (pelas chamadas a impstr)
+;   antes de clonar e depois de criar todos, quando copia as páginas que
+;   escreve
+; para executar, troque 'p1.maq' por 'muitos.maq' em init.asm
+
+; chamadas de sistema (ver so.h)
+SO_ESCR        define 2
+SO_MATA_PROC   define 8
+SO_CLONA_PROC  define 10
+
+N        define 2000 ; número de clones
+GIROS    define 5000   ; voltas do laço de cada clone
+
+limpa    define 10
+
+         cargi msg_ini
+         chama impstr
+         cargi limpa
+         chama impch
+
+         ; X conta os clones criados
+         cargi 0
+         trax
+laco     cargi SO_CLONA_PROC
+         chamas
+         desvz clone    ; A é 0 no clone
+         desvn erro     ; e negativo se não conseguiu clonar
+         incx
+         cpxa
+         sub ene
+         desvnz laco
+
+         cargi msg_fim
+         chama impstr
+         desv morre
+
+erro     cargi msg_erro
+         chama impstr
+
+morre    cargi 0
+         trax
+         cargi SO_MATA_PROC
+         chamas
+         desv morre
+
+; o clone dá GIROS voltas, contando em X, e morre (sem escrever na memória)
+clone    cargi 0
+         trax
+gira     incx
+         cpxa
+         sub giros
+         desvnz gira
+         desv morre
+
+ene      valor N
+giros    valor GIROS
+msg_ini  string 'criando clones...'
+msg_fim  string 'clones criados'
+msg_erro string 'erro ao clonar!'
+
+; imprime a string que inicia em A (destroi X)
+impstr   espaco 1
+         TRAX
+impstr1
+         CARGX 0
+         DESVZ impstrf
+         CHAMA impch
+         INCX
+         DESV impstr1
+impstrf  RET impstr
+
+; função que chama o SO para imprimir o caractere em A
+; retorna em A o código de erro do SO
+; não altera o valor de X
+impch    espaco 1
+         trax
+         armm impch_X
+         cargi SO_ESCR
+         chamas
+         trax
+         cargm impch_X
+         trax
+         ret impch
+impch_X  espaco 1 ; para salvar o valor de X
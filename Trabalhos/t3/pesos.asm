@@ -0,0 +1,98 @@
+; programa de exemplo para SO
+; carga para a divisão da CPU pelo peso (ver SO_PESO_PROC)
+; clona a si mesmo 2 vezes; os 3 processos mudam o peso (P0, P1 e P2), dão
+;   GIROS voltas em um laço só de CPU, escrevem uma mensagem e morrem
+; com a política cfs, cada um recebe CPU na proporção do peso enquanto os 3
+;   executam, e o de maior peso termina primeiro; as outras políticas não
+;   olham o peso (compare o erro de fração justa no relatório de métricas)
+; para executar, troque 'p1.maq' por 'pesos.maq' em init.asm
+
+; chamadas de sistema (ver so.h)
+SO_ESCR        define 2
+SO_MATA_PROC   define 8
+SO_CLONA_PROC  define 10
+SO_PESO_PROC   define 11
+
+P0       define 10 ; o peso padrão
+P1       define 20
+P2       define 40
+GIROS    define 20000 ; voltas do laço de cada processo
+
+         cargi SO_CLONA_PROC
+         chamas
+         desvz clone1   ; A é 0 no clone
+         desvn erro
+         cargi SO_CLONA_PROC
+         chamas
+         desvz clone2
+         desvn erro
+         cargi msg_p0
+         armm minha_msg
+         cargi P0
+         desv pesa
+clone1   cargi msg_p1
+         armm minha_msg
+         cargi P1
+         desv pesa
+clone2   cargi msg_p2
+         armm minha_msg
+         cargi P2
+
+         ; muda o peso para o valor em A
+pesa     trax
+         cargi SO_PESO_PROC
+         chamas
+         desvn erro     ; A é o peso anterior, ou negativo se deu erro
+
+         ; dá GIROS voltas, contando em X
+         cargi 0
+         trax
+gira     incx
+         cpxa
+         sub giros
+         desvnz gira
+
+         cargm minha_msg
+         chama impstr
+         desv morre
+
+erro     cargi msg_erro
+         chama impstr
+
+morre    cargi 0
+         trax
+         cargi SO_MATA_PROC
+         chamas
+         desv morre
+
+giros    valor GIROS
+minha_msg espaco 1
+msg_p0   string 'peso 10: fim '
+msg_p1   string 'peso 20: fim '
+msg_p2   string 'peso 40: fim '
+msg_erro string 'erro! '
+
+; imprime a string que inicia em A (destroi X)
+impstr   espaco 1
+         TRAX
+impstr1
+         CARGX 0
+         DESVZ impstrf
+         CHAMA impch
+         INCX
+         DESV impstr1
+impstrf  RET impstr
+
+; função que chama o SO para imprimir o caractere em A
+; retorna em A o código de erro do SO
+; não altera o valor de X
+impch    espaco 1
+         trax
+         armm impch_X
+         cargi SO_ESCR
+         chamas
+         trax
+         cargm impch_X
+         trax
+         ret impch
+impch_X  espaco 1 ; para salvar o valor de X
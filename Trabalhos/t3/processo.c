@@ -12,6 +12,11 @@ pcb* criar_processo(dispositivo_id_t entrada, dispositivo_id_t saida) {
     }
     novo_processo->usando = 1; // Marcado como ocupado
     novo_processo->pid = pid_inicial++; //processo começa com pid 1 
+    novo_processo->indice = -1; // ainda não está na tabela
+    novo_processo->fila = NULL;
+    novo_processo->prox_fila = NULL;
+    novo_processo->ant_fila = NULL;
+    novo_processo->prox_hash = NULL;
     novo_processo->estado = P_PRONTO; // Estado inicial como pronto
     //novo_processo->ctx_cpu.pc = pc; //salva o antigo valor de pc 
     novo_processo->ctx_cpu.regA = 0;
@@ -20,15 +25,36 @@ pcb* criar_processo(dispositivo_id_t entrada, dispositivo_id_t saida) {
     novo_processo->ctx_cpu.complemento = 0;
     novo_processo->entrada = entrada;
     novo_processo->saida = saida;
+    novo_processo->conta_terminal = false;
     novo_processo->dispositivo_bloqueado = -1; // Nenhum dispositivo bloqueado inicialmente
     novo_processo->pid_esperando = -1; // Nenhum processo esperando inicialmente
+    fila_inicializa(&novo_processo->esperando_fim);
     novo_processo->quantum = QUANTUM; // Inicializa o quantum
+    novo_processo->pos_heap = -1;
+    novo_processo->prioridade = 0.5;
+    novo_processo->nivel = 0;
+    novo_processo->peso = PESO_PADRAO;
+    novo_processo->vruntime = 0;
+    novo_processo->fatia = 0;
+    novo_processo->executado_fatia = 0;
+    novo_processo->epoca_boost = -1; // o MLFQ acerta o nível e o quantum
     novo_processo->tabela_paginas = tabpag_cria(); // Cria a tabela de páginas
     novo_processo->page_faults = 0; // Inicializa o contador de page faults
+    novo_processo->imagem = NULL;
+    novo_processo->prox_usuario = NULL;
+    novo_processo->ant_usuario = NULL;
+    novo_processo->copias = NULL;
     novo_processo->swap_pendente = 0;
     novo_processo->pending_swap_quadro = -1;
     novo_processo->pending_swap_end_causador = -1;
     novo_processo->desbloqueio_ate = -1;
+    novo_processo->primeiro_quadro = -1;
+    novo_processo->num_quadros = 0;
+    novo_processo->num_paginas = 0;
+    novo_processo->proxima_falta_seq = -1;
+    novo_processo->janela_leitura = 0;
+    novo_processo->pg_adiantada = 0;
+    novo_processo->n_adiantadas = 0;
     return novo_processo;
 }
 
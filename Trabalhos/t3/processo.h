@@ -1,12 +1,20 @@
 #ifndef PROCESSO_H
 #define PROCESSO_H
 
-#define QUANTUM 10
-#define MAX_PROCESSES 4
+#define QUANTUM 10 // em interrupções de relógio (ver escalonador.h)
+// peso de um processo na divisão da CPU (ver SO_PESO_PROC)
+#define PESO_PADRAO 10
+#define PESO_MAX 1000
+#define MAX_PROCESSES 8192 // máximo de processos existindo ao mesmo tempo (ver tabproc.h)
 #define NO_PROCESS -1
+#define MAX_LEITURA_ADIANTADA 4 // máximo de páginas lidas adiante em uma falta
 #include <stdio.h>
 #include "tabpag.h"
 #include "dispositivos.h"
+#include "fila.h"
+
+struct imagem_t;
+struct copia_t;
 
 typedef enum {
     P_PRONTO,       // pronto para executar
@@ -37,17 +45,33 @@ PROCESSO INDIVIDUAL
 9- tempo total de cada processo em cada estado (pronto, bloqueado, executando)
 10- tempo médio de resposta de cada processo (tempo entre desbloquear e ser escalonado)
  */
-typedef struct {
+typedef struct pcb {
     int usando;         // 1 se ocupado, 0 se livre
     int pid;          // identificador único do processo
+    int indice;       // posição do processo na tabela de processos
+    struct pcb *prox_hash; // próximo na lista do espalhamento por pid (ver tabproc.h)
+    // fila em que o processo está (prontos ou espera), e elos dela (ver fila.h)
+    struct fila *fila;
+    struct pcb *prox_fila, *ant_fila;
     estado_processo estado;    // estado atual
     cpu_ctx ctx_cpu;         // registradores salvos
     dispositivo_id_t entrada;
     dispositivo_id_t saida;
+    bool conta_terminal;    // está contado entre os usuários do terminal (ver so.c)
 
     int dispositivo_bloqueado; // dispositivo que causou o bloqueio (se houver)
-    int pid_esperando;       // PID do processo que está esperando este (se houver)
+    int pid_esperando;       // PID do processo pelo qual este está esperando (se houver)
+    fila esperando_fim;      // processos bloqueados esperando este terminar
     int quantum;              // tempo restante no quantum
+    // dados das políticas de escalonamento (ver esc_*.c)
+    int pos_heap;             // posição no heap de prontos (ver heap.h), -1 se fora
+    double prioridade;        // prioridade: fração média do quantum usada
+    int nivel;                // MLFQ: nível (0 é o de maior prioridade)
+    int epoca_boost;          // MLFQ: época do último boost visto pelo processo
+    int peso;                 // peso na divisão da CPU (SO_PESO_PROC)
+    double vruntime;          // CFS: tempo de execução ponderado pelo peso
+    int fatia;                // CFS: instruções que pode executar ao ser escolhido
+    int executado_fatia;      // CFS: instruções executadas desde que foi escolhido
     //métricas
     int tempo_criacao;      // 6 - tempo de criação do processo
     int tempo_termino;      // 6- tempo de término do processo
@@ -60,8 +84,17 @@ typedef struct {
     int tempo_desbloqueou; // Timestamp de quando saiu de BLOQUEADO
     int tempo_total_resposta_pos_bloqueio;// soma dos tempos de resposta pós bloqueio
     int num_respostas_pos_bloqueio; // N. de vezes que foi de BLOQUEADO -> PRONTO 
+    // 12- fração justa: tempo virtual do sistema quando o processo ficou
+    //   pronto, e o tempo de CPU que caberia a ele pelo peso (ver so_muda_estado)
+    double v_pronto;
+    double tempo_devido;
     tabpag_t* tabela_paginas; // tabela de páginas do processo
-    int end_disco; // índice do bloco de memória onde está o código do processo
+    int end_disco; // endereço na memória secundária da imagem do programa do processo
+    // imagem do programa, compartilhada com os outros processos que executam o
+    //   mesmo programa (ver imagem.h)
+    struct imagem_t *imagem;
+    struct pcb *prox_usuario, *ant_usuario; // lista dos processos que usam a imagem
+    struct copia_t **copias;         // cópia de cada página (NULL se é a da imagem)
     int page_faults; // número de page faults do processo
     /* em processo.h - no struct pcb */
     // campos para swap pendente (page-fault)
@@ -69,6 +102,16 @@ typedef struct {
     int pending_swap_quadro;         // quadro físico reservado para receber a página (ou -1)
     int pending_swap_end_causador;   // endereço virtual que causou o page fault (complemento)
     int desbloqueio_ate;             // tempo (instruções) até o qual o processo fica bloqueado por causa do swap
+    // quadros da memória física com páginas do processo (ver donos_quadros_t)
+    int primeiro_quadro;             // início da lista de quadros residentes (-1 se vazia)
+    int num_quadros;                 // número de quadros residentes
+    // leitura adiantada de páginas (ver so_trata_page_fault)
+    int num_paginas;                 // número de páginas do programa no disco
+    int proxima_falta_seq;           // página que continua a sequência de faltas (-1 se nenhuma)
+    int janela_leitura;              // páginas a ler adiante na próxima falta sequencial
+    int pg_adiantada;                // primeira página da janela lida adiantada
+    int n_adiantadas;                // número de páginas na janela
+    int quadros_adiantados[MAX_LEITURA_ADIANTADA]; // quadro de cada página da janela (-1 se usada ou descartada)
 } pcb;
 
 //a struct que guardará as métricas finais, é um histórico de processos finalizados
@@ -94,6 +137,10 @@ typedef struct {
     int num_respostas_pos_bloqueio;
     //
     int total_page_faults; // número total de page faults do processo
+
+    //métrica 12
+    int peso;
+    double tempo_devido;
 } metricas_processo_final_t;
 
 pcb* criar_processo( dispositivo_id_t entrada, dispositivo_id_t saida);
@@ -7,11 +7,25 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// o formato binário tem palavras de 32 bits, que são lidas direto para int
+_Static_assert(sizeof(int) == sizeof(int32_t), "int deve ter 32 bits");
+
+// número de palavras do cabeçalho do formato binário
+#define TAM_CABECALHO 3
 
 struct programa_t {
   int carga;
   int tamanho;
   int *dados;
+  int *bloco;  // memória alocada (os dados podem estar no meio dela)
 };
 
 // lê os dados do cabeçalho do arquivo (1ª linha)
@@ -27,6 +41,7 @@ static programa_t *pega_cabecalho(char *lin)
     free(prog);
     return NULL;
   }
+  prog->bloco = prog->dados;
   prog->tamanho = tam;
   prog->carga = carga;
   return prog;
@@ -50,12 +65,10 @@ static void pega_dados(programa_t *self, char *lin)
   }
 }
 
-programa_t *prog_cria(char *nome)
+// lê um programa no formato texto
+static programa_t *prog_cria_texto(FILE *arq)
 {
   programa_t *prog = NULL;
-  FILE *arq = fopen(nome, "r");
-  if (arq == NULL) return NULL;
-
   char *linha = NULL;
   size_t tam_lin;
   if (getline(&linha, &tam_lin, arq) == -1) goto fim;
@@ -69,13 +82,89 @@ programa_t *prog_cria(char *nome)
 
 fim:
   free(linha);
-  fclose(arq);
+  return prog;
+}
+
+static bool maquina_little_endian(void)
+{
+  uint32_t um = 1;
+  return *(unsigned char *)&um == 1;
+}
+
+// converte uma palavra lida do arquivo (little-endian) para o formato da máquina
+static int32_t le32(int32_t palavra)
+{
+  if (maquina_little_endian()) return palavra;
+  unsigned char *b = (unsigned char *)&palavra;
+  return (int32_t)((uint32_t)b[0] | (uint32_t)b[1] << 8
+                   | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24);
+}
+
+// cria um programa no formato binário, com o conteúdo 'bloco' do arquivo,
+//   que tem 'tam_arq' bytes
+// os dados ficam no bloco, logo depois do cabeçalho; o bloco passa a ser do
+//   programa (ou é liberado, em caso de erro)
+static programa_t *prog_cria_binario(int32_t *bloco, off_t tam_arq)
+{
+  int n_palavras = tam_arq / sizeof(int32_t);
+  if (n_palavras < TAM_CABECALHO) goto erro;
+  for (int i = 0; !maquina_little_endian() && i < n_palavras; i++) {
+    bloco[i] = le32(bloco[i]);
+  }
+  int tamanho = bloco[1];
+  if (tamanho < 0 || tamanho > n_palavras - TAM_CABECALHO) goto erro;
+  programa_t *prog = malloc(sizeof(*prog));
+  if (prog == NULL) goto erro;
+  prog->bloco = bloco;
+  prog->tamanho = tamanho;
+  prog->carga = bloco[2];
+  prog->dados = bloco + TAM_CABECALHO;
+  return prog;
+
+erro:
+  free(bloco);
+  return NULL;
+}
+
+// lê o programa do arquivo aberto em 'fd', que tem 'tam_arq' bytes
+// o arquivo inteiro é lido de uma vez; se não for binário, o texto é
+//   interpretado a partir da memória
+static programa_t *prog_cria_fd(int fd, off_t tam_arq)
+{
+  if (tam_arq <= 0) return NULL;
+  int32_t *bloco = malloc(tam_arq + sizeof(int32_t));
+  if (bloco == NULL) return NULL;
+  if (pread(fd, bloco, tam_arq, 0) != tam_arq) {
+    free(bloco);
+    return NULL;
+  }
+  if (tam_arq >= (off_t)sizeof(int32_t) && le32(bloco[0]) == PROG_MAGICO) {
+    return prog_cria_binario(bloco, tam_arq);
+  }
+  programa_t *prog = NULL;
+  FILE *arq = fmemopen(bloco, tam_arq, "r");
+  if (arq != NULL) {
+    prog = prog_cria_texto(arq);
+    fclose(arq);
+  }
+  free(bloco);
+  return prog;
+}
+
+programa_t *prog_cria(char *nome)
+{
+  int fd = open(nome, O_RDONLY);
+  if (fd < 0) return NULL;
+  struct stat st;
+  programa_t *prog = NULL;
+  if (fstat(fd, &st) == 0) prog = prog_cria_fd(fd, st.st_size);
+  close(fd);
   return prog;
 }
 
 void prog_destroi(programa_t *self)
 {
-  free(self->dados);
+  free(self->bloco);
   free(self);
 }
 
@@ -99,3 +188,108 @@ int prog_dado(programa_t *self, int ender)
   if (ender < self->carga || ender >= self->carga + self->tamanho) return -1;
   return self->dados[ender - self->carga];
 }
+
+const int *prog_dados(programa_t *self)
+{
+  return self->dados;
+}
+
+
+// CACHE DE PROGRAMAS
+
+// são poucos programas diferentes; uma lista simplesmente encadeada basta
+typedef struct programa_no_t {
+  char *nome;
+  struct timespec alteracao;  // data da última alteração do arquivo lido
+  off_t tam_arq;
+  programa_t *programa;
+  struct programa_no_t *prox;
+} programa_no_t;
+
+struct programas_t {
+  programa_no_t *primeiro;
+  int acertos;
+  int leituras;
+};
+
+programas_t *programas_cria(void)
+{
+  programas_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->primeiro = NULL;
+  self->acertos = 0;
+  self->leituras = 0;
+  return self;
+}
+
+void programas_destroi(programas_t *self)
+{
+  if (self == NULL) return;
+  while (self->primeiro != NULL) {
+    programa_no_t *no = self->primeiro;
+    self->primeiro = no->prox;
+    prog_destroi(no->programa);
+    free(no->nome);
+    free(no);
+  }
+  free(self);
+}
+
+// retorna true se o arquivo não mudou desde que o programa do nó foi lido
+static bool programas_no_valido(programa_no_t *no, struct stat *st)
+{
+  return no->alteracao.tv_sec == st->st_mtim.tv_sec
+      && no->alteracao.tv_nsec == st->st_mtim.tv_nsec
+      && no->tam_arq == st->st_size;
+}
+
+programa_t *programas_pega(programas_t *self, char *nome)
+{
+  // só as informações do arquivo são consultadas; o conteúdo só é lido se
+  //   o programa não estiver no cache ou tiver mudado
+  struct stat st;
+  if (stat(nome, &st) != 0) return NULL;
+  programa_no_t *no;
+  for (no = self->primeiro; no != NULL; no = no->prox) {
+    if (strcmp(no->nome, nome) == 0) break;
+  }
+  if (no != NULL && programas_no_valido(no, &st)) {
+    self->acertos++;
+    return no->programa;
+  }
+
+  int fd = open(nome, O_RDONLY);
+  if (fd < 0) return NULL;
+  programa_t *prog = NULL;
+  // a data usada é a do arquivo aberto, para não associar o conteúdo novo
+  //   à data antiga se ele mudar entre o stat e o open
+  if (fstat(fd, &st) == 0) prog = prog_cria_fd(fd, st.st_size);
+  close(fd);
+  if (prog == NULL) return NULL;
+  self->leituras++;
+
+  if (no == NULL) {
+    no = malloc(sizeof(*no));
+    assert(no != NULL);
+    no->nome = strdup(nome);
+    assert(no->nome != NULL);
+    no->prox = self->primeiro;
+    self->primeiro = no;
+  } else {
+    prog_destroi(no->programa);
+  }
+  no->alteracao = st.st_mtim;
+  no->tam_arq = st.st_size;
+  no->programa = prog;
+  return prog;
+}
+
+int programas_acertos(programas_t *self)
+{
+  return self->acertos;
+}
+
+int programas_leituras(programas_t *self)
+{
+  return self->leituras;
+}
@@ -7,10 +7,23 @@
 #define PROGRAMA_H
 
 // TAD para representar um programa lido de um arquivo '.maq'
+// o arquivo pode estar em dois formatos, gerados pelo montador:
+// - texto: uma linha "//MAQ tamanho carga", seguida de linhas com o endereço
+//   entre colchetes e os valores a partir dele, separados por vírgula
+// - binário (montador -b): um cabeçalho com 3 palavras (PROG_MAGICO, tamanho,
+//   carga), seguido das 'tamanho' palavras do programa; cada palavra tem 32
+//   bits, em little-endian
+// o arquivo é lido com um único read, nos dois formatos; no binário, os
+//   dados são usados onde foram lidos, sem conversão (em máquinas
+//   little-endian)
 
 typedef struct programa_t programa_t;
 
-// cria e inicializa um programa com o conteúdo do arquivo 'nome'
+// primeira palavra de um arquivo .maq binário ("MAQB", em little-endian)
+#define PROG_MAGICO 0x4251414d
+
+// cria e inicializa um programa com o conteúdo do arquivo 'nome', em qualquer
+//   um dos formatos
 // retorna NULL em caso de erro
 programa_t *prog_cria(char *nome);
 
@@ -31,4 +44,30 @@ int prog_end_inicio(programa_t *self);
 // valor a colocar na posição 'ender' da memória
 int prog_dado(programa_t *self, int ender);
 
+// vetor com os prog_tamanho() valores a colocar na memória, a partir do
+//   endereço de carga
+// o vetor pertence ao programa, e deixa de existir com prog_destroi
+const int *prog_dados(programa_t *self);
+
+
+// cache de programas já lidos, para que criar vários processos com o mesmo
+//   programa não precise ler o arquivo de novo
+// cada programa é identificado pelo nome do arquivo e pela data da sua última
+//   alteração: se o arquivo mudar, é lido de novo
+typedef struct programas_t programas_t;
+
+programas_t *programas_cria(void);
+// destrói o cache e os programas que estão nele
+void programas_destroi(programas_t *self);
+
+// retorna o programa do arquivo 'nome', do cache ou lido com prog_cria (e
+//   colocado no cache)
+// o programa pertence ao cache, e não deve ser destruído; ele continua
+//   válido até o cache ser destruído ou o arquivo mudar e ser lido de novo
+// retorna NULL se o arquivo não existir ou não puder ser lido
+programa_t *programas_pega(programas_t *self, char *nome);
+// número de leituras de arquivo evitadas pelo cache, e de arquivos lidos
+int programas_acertos(programas_t *self);
+int programas_leituras(programas_t *self);
+
 #endif // PROGRAMA_H
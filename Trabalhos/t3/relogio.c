@@ -26,6 +26,9 @@ relogio_t *relogio_cria(void)
   assert(self != NULL);
 
   self->agora = 0;
+  // timer desligado
+  self->t_ate_interrupcao = 0;
+  self->interrupcao_ativa = false;
 
   return self;
 }
@@ -47,6 +50,24 @@ void relogio_tictac(relogio_t *self)
   }
 }
 
+void relogio_avanca(relogio_t *self, int n)
+{
+  self->agora += n;
+  if (self->t_ate_interrupcao != 0) {
+    if (n >= self->t_ate_interrupcao) {
+      self->t_ate_interrupcao = 0;
+      self->interrupcao_ativa = true;
+    } else {
+      self->t_ate_interrupcao -= n;
+    }
+  }
+}
+
+int relogio_tics_ate_interrupcao(relogio_t *self)
+{
+  return self->t_ate_interrupcao;
+}
+
 err_t relogio_leitura(void *disp, int id, int *pvalor)
 {
   relogio_t *self = disp;
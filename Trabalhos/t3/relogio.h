@@ -36,6 +36,15 @@ void relogio_destroi(relogio_t *self);
 // esta função é chamada pelo controlador após a execução de cada instrução
 void relogio_tictac(relogio_t *self);
 
+// registra a passagem de 'n' unidades de tempo de uma vez, com o mesmo
+//   efeito de 'n' chamadas a relogio_tictac
+// usado pelo controlador para avançar o tempo enquanto a CPU está parada
+void relogio_avanca(relogio_t *self, int n);
+
+// retorna quantas unidades de tempo faltam para o timer gerar interrupção,
+//   ou 0 se o timer estiver desligado
+int relogio_tics_ate_interrupcao(relogio_t *self);
+
 // Funções para acessar o relógio como dispositivo de E/S, com id:
 //   '0' para ler o relógio local (contador de instruções)
 //   '1' para ler o tempo de CPU consumido pelo simulador (em ms)
@@ -19,9 +19,13 @@
 #include "fila.h"
 #include "metricas.h"
 #include "bloco.h"
+#include "imagem.h"
+#include "tabproc.h"
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <assert.h>
+#include <sys/stat.h>
 
 // ---------------------------------------------------------------------
 // CONSTANTES E TIPOS {{{1
@@ -30,6 +34,7 @@
 // intervalo entre interrupções do relógio
 #define INTERVALO_INTERRUPCAO 50  // em instruções executadas
 #define TERMINAIS 4
+#define TAM_INICIAL_TABELA 4 // posições iniciais da tabela de processos (ela cresce)
 
  // tamanho da memória física em bytes
 // Não tem processos nem memória virtual, mas é preciso usar a paginação,
@@ -57,7 +62,7 @@
 define NENHUM_PROCESSO -1
 #define ALGUM_PROCESSO 0 */
 #define NENHUM_PROCESSO NULL
-#define ALG_SUBSTITUICAO 0//escolher algoritmo de substituição de páginas (0 = FIFO, 1 = LRU)
+#define ALG_SUBSTITUICAO ALG_FIFO //escolher algoritmo de substituição de páginas (ALG_FIFO, ALG_LRU, ALG_RELOGIO, ALG_RELOGIO_MELHORADO; ver so.h)
 #define DISCO_BLOQUEIO    -2   // valor especial para proc->dispositivo_bloqueado: bloqueado por disco
 #define TEMPO_TRANSFER_PAGINA  1 // tempo de transferência em "instruções" de uma página entre memória secundária e física
 #define PID_RESERVADO -2
@@ -71,21 +76,36 @@ struct so_t {
 
   int regA, regX, regPC, regERRO, regComplemento; // cópia do estado da CPU
   // t2: tabela de processos, processo corrente, pendências, etc
-  pcb *tabela_de_processos[MAX_PROCESSES];
+  tabproc_t *tabela_de_processos; // processos que existem (ver tabproc.h)
   int processo_corrente; // índice na tabela de processos
-  // vetor para guardar os pids dos processos que estão usando os terminais
+  // número de processos usando cada terminal (o criado para ele e os seus
+  //   clones); o terminal está livre quando é 0
   // idx = 0 -> terminal A
   // idx = 1 -> terminal B...
   int terminais_usados[4];
-  fila *fila_prontos;   // fila de processos prontos
+  escalonador_t *escalonador; // guarda os prontos e escolhe o próximo (ver escalonador.h)
+  // processos bloqueados, separados pela causa, para que o tratamento de
+  //   pendências só veja os que podem ser desbloqueados (os que esperam outro
+  //   processo terminar ficam na fila 'esperando_fim' do outro), e os que
+  //   terminaram e ainda não saíram da tabela
+  fila *fila_bloqueados_es;    // esperando um dispositivo (dispositivo_bloqueado)
+  fila *fila_bloqueados_disco; // esperando uma transferência de página, na ordem
+                               //   em que as transferências terminam
+  fila *fila_terminados;
   metricas_t *metricas;
   // t3: com memória virtual
   mem_t *mem_sec; // memória física do sistema
-  int bloco_livre; // índice do primeiro bloco livre na memória física
+  mapa_disco_t *mapa_disco; // páginas livres da memória secundária
+  imagens_t *imagens; // imagens dos programas em execução, compartilhadas
+  programas_t *programas; // programas já lidos dos arquivos
   bloco_t* blocos_memoria; // rastreador de blocos de memória física
+  quadros_livres_t *quadros_livres; // mapa de bits dos quadros livres
+  donos_quadros_t *donos_quadros; // dono e idade (LRU) de cada quadro
   int num_paginas_fisicas; // número de páginas na memória física
   int disco_livre_ate;
   int tempo_transfer_pagina;
+  int ponteiro_relogio; // próximo quadro a examinar no algoritmo CLOCK
+  int ponteiro_limpeza; // próximo quadro a examinar pelo limpador de páginas
 };
 
 
@@ -108,7 +128,7 @@ static bool so_copia_str_do_processo(so_t *self, int tam, char str[tam],
 // ---------------------------------------------------------------------
 
 so_t *so_cria(cpu_t *cpu, mem_t *mem, mem_t *mem_fisica, mmu_t *mmu,
-              es_t *es, console_t *console)
+              es_t *es, console_t *console, esc_politica_t politica)
 {
   so_t *self = malloc(sizeof(*self));
   if (self == NULL) return NULL;
@@ -124,16 +144,24 @@ so_t *so_cria(cpu_t *cpu, mem_t *mem, mem_t *mem_fisica, mmu_t *mmu,
   self->console = console;
   self->erro_interno = false;
   // t3: inicializa controle de memória física
-  self->bloco_livre = 0;
+  self->mapa_disco = mapa_disco_cria(mem_tam(self->mem_sec) / TAM_PAGINA);
+  self->imagens = imagens_cria();
+  self->programas = programas_cria();
   self->num_paginas_fisicas = mem_tam(self->mem) / TAM_PAGINA;
   self->blocos_memoria = cria_bloco(self->num_paginas_fisicas);
+  self->quadros_livres = quadros_livres_cria(self->num_paginas_fisicas);
+  self->donos_quadros = donos_quadros_cria(self->num_paginas_fisicas);
    // processos
   self->processo_corrente = NO_PROCESS;
 
   // quando a CPU executar uma instrução CHAMAC, deve chamar a função
   //   so_trata_interrupcao, com primeiro argumento um ptr para o SO
   cpu_define_chamaC(self->cpu, so_trata_interrupcao, self);
-  self->fila_prontos = cria_fila();
+  self->tabela_de_processos = tabproc_cria(TAM_INICIAL_TABELA, MAX_PROCESSES);
+  self->escalonador = esc_cria(politica);
+  self->fila_bloqueados_es = cria_fila();
+  self->fila_bloqueados_disco = cria_fila();
+  self->fila_terminados = cria_fila();
   // inicializar terminais
   for (int i = 0; i < TERMINAIS; i++)
   {
@@ -142,6 +170,8 @@ so_t *so_cria(cpu_t *cpu, mem_t *mem, mem_t *mem_fisica, mmu_t *mmu,
   self->metricas = metricas_cria();
   self->disco_livre_ate = 0;
   self->tempo_transfer_pagina = TEMPO_TRANSFER_PAGINA;
+  self->ponteiro_relogio = BLOCOS_RESERVADOS;
+  self->ponteiro_limpeza = BLOCOS_RESERVADOS;
   
   return self;
 
@@ -158,6 +188,13 @@ void so_destroi(so_t *self)
 {
   cpu_define_chamaC(self->cpu, NULL, NULL);
   metricas_destroi(self->metricas);
+  quadros_livres_destroi(self->quadros_livres);
+  donos_quadros_destroi(self->donos_quadros);
+  mapa_disco_destroi(self->mapa_disco);
+  imagens_destroi(self->imagens);
+  programas_destroi(self->programas);
+  tabproc_destroi(self->tabela_de_processos);
+  esc_destroi(self->escalonador);
   free(self);
 }
 // ---------------------------------------------------------------------
@@ -169,7 +206,7 @@ metricas_t* so_get_metricas(so_t *self) {
 es_t* so_get_es(so_t *self) {
   return self->es;
 }
-pcb** so_get_tabela_de_processos(so_t *self) {
+tabproc_t* so_get_tabela_de_processos(so_t *self) {
   return self->tabela_de_processos;
 }
 int so_get_processo_corrente(so_t *self) {
@@ -183,6 +220,10 @@ int so_get_algoritmo_substituicao(so_t *self) {
   return ALG_SUBSTITUICAO;
 }
 
+escalonador_t* so_get_escalonador(so_t *self) {
+  return self->escalonador;
+}
+
 int so_get_tamanho_memoria_fisica(so_t *self) {
   return mem_tam(self->mem);
 }
@@ -190,6 +231,15 @@ int so_get_tamanho_memoria_fisica(so_t *self) {
 int so_get_tamanho_pg(so_t *self) {
   return TAM_PAGINA;
 }
+mmu_t* so_get_mmu(so_t *self) {
+  return self->mmu;
+}
+mapa_disco_t* so_get_mapa_disco(so_t *self) {
+  return self->mapa_disco;
+}
+programas_t* so_get_programas(so_t *self) {
+  return self->programas;
+}
 // ---------------------------------------------------------------------
 // TRATAMENTO DE INTERRUPÇÃO {{{1
 // ---------------------------------------------------------------------
@@ -200,11 +250,21 @@ static void so_trata_irq(so_t *self, int irq);
 static void so_trata_pendencias(so_t *self);
 static void so_escalona(so_t *self);
 static int so_despacha(so_t *self);
-static void libera_terminal(so_t *self, int pid);
+static void so_usa_terminal(so_t *self, pcb *proc);
+static void libera_terminal(so_t *self, pcb *proc);
 static pcb *achar_processo(so_t *self, int pid);
+static pcb *so_proc_corrente(so_t *self);
+static void so_torna_pronto(so_t *self, pcb *proc);
 /* protótipos para funções de swap agendado (evita implicit declaration) */
 static void schedule_page_transfer(so_t *self, pcb *proc, int end_causador, int pg_dest);
 static void complete_pending_swap(so_t *self, pcb *proc);
+static void so_completa_leitura_adiantada(so_t *self, pcb *proc);
+static void so_descarta_leitura_adiantada(so_t *self, pcb *proc);
+static void so_desperdica_pagina_adiantada(so_t *self, pcb *proc, int pagina);
+static void so_limpa_paginas(so_t *self);
+static bool so_trata_escrita_protegida(so_t *self, pcb *proc);
+static void so_libera_memoria_do_processo(so_t *self, pcb *proc);
+static void so_acorda_processos_esperando(so_t *self, pcb *proc_que_morreu);
 // função a ser chamada pela CPU quando executa a instrução CHAMAC, no tratador de
 //   interrupção em assembly
 // essa é a única forma de entrada no SO depois da inicialização
@@ -271,20 +331,17 @@ static void so_salva_estado_da_cpu(so_t *self)
     contexto.regX = self->regX;
     contexto.erro = self->regERRO;
     contexto.complemento = self->regComplemento;
-    self->tabela_de_processos[self->processo_corrente]->ctx_cpu = contexto;
+    so_proc_corrente(self)->ctx_cpu = contexto;
   }
 
 }
 
-static void debug_imprime_tabela_processos(so_t *self)
+// quantos processos o dump de depuração mostra, no máximo: ele é feito a
+//   cada interrupção, e não pode custar o tamanho da tabela
+#define DEBUG_MAX_PROCESSOS 8
+
+static void debug_imprime_processo(pcb *p)
 {
-  console_printf("DEBUG: tabela_de_processos:");
-  for (int i = 0; i < MAX_PROCESSES; i++) {
-    pcb *p = self->tabela_de_processos[i];
-    if (p == NULL) {
-      console_printf("  [%d] NULL", i);
-      continue;
-    }
     const char *estado_s = "(?)";
     switch (p->estado) {
       case P_PRONTO:      estado_s = "PRONTO";      break;
@@ -294,18 +351,79 @@ static void debug_imprime_tabela_processos(so_t *self)
       default:            estado_s = "DESCONHECIDO"; break; /* cobre P_N_ESTADOS e quaisquer valores inválidos */
     }
     console_printf("  [%d] pid=%d estado=%s pc=%d regA=%d disp_bloq=%d pid_esperando=%d swap_pendente=%d end_disco=%d page_faults=%d",
-                   i,
+                   p->indice,
                    p->pid,
                    estado_s,
                    p->ctx_cpu.pc,
                    p->ctx_cpu.regA,
                    p->dispositivo_bloqueado,
-                   /* use pid_esperando se existir no seu PCB, ajustar nome caso diferente */
                    p->pid_esperando,
-                   /* swap_pendente pode não existir no seu PCB; se não existir, remova ou substitua por 0/flag adequada */
-                   (/* assumindo que exista */ p->swap_pendente ? 1 : 0),
+                   p->swap_pendente ? 1 : 0,
                    p->end_disco,
                    p->page_faults);
+}
+
+// mostra os processos da fila, enquanto o total mostrado (que era 'n') não
+//   chegar a DEBUG_MAX_PROCESSOS; retorna o novo total
+static int debug_imprime_fila(fila *f, int n)
+{
+  for (pcb *p = fila_primeiro(f); p != NULL && n < DEBUG_MAX_PROCESSOS; p = p->prox_fila) {
+    debug_imprime_processo(p);
+    n++;
+  }
+  return n;
+}
+
+// mostra o processo corrente e os das filas de bloqueados e terminados, até
+//   DEBUG_MAX_PROCESSOS (dos prontos, e dos que esperam outro processo
+//   terminar, só os pids)
+static void debug_imprime_tabela_processos(so_t *self)
+{
+  int num = tabproc_num(self->tabela_de_processos);
+  console_printf("DEBUG: tabela_de_processos: %d processos em %d posições",
+                 num, tabproc_tamanho(self->tabela_de_processos));
+  int n = 0;
+  pcb *corrente = so_proc_corrente(self);
+  if (corrente != NULL) {
+    debug_imprime_processo(corrente);
+    n++;
+  }
+  esc_imprime(self->escalonador);
+  n = debug_imprime_fila(self->fila_bloqueados_es, n);
+  n = debug_imprime_fila(self->fila_bloqueados_disco, n);
+  n = debug_imprime_fila(self->fila_terminados, n);
+  if (num > n) console_printf("  ... e mais %d", num - n);
+}
+
+// completa as transferências de página que já terminaram
+// o disco faz uma transferência de cada vez, então elas terminam na ordem em
+//   que foram agendadas, que é a ordem da fila: a busca para na primeira que
+//   ainda não terminou
+static void so_completa_transferencias(so_t *self)
+{
+  int agora = so_tempo_total(self);
+  pcb *proc;
+  while ((proc = fila_primeiro(self->fila_bloqueados_disco)) != NULL) {
+    if (proc->swap_pendente && agora < proc->desbloqueio_ate) break;
+    console_printf("========= BLOQUEIO POR DISCO - VERIFICAR SWAP PENDENTE   %d", proc->pid);
+    complete_pending_swap(self, proc);
+    if (proc->fila == self->fila_bloqueados_disco) {
+      // a transferência não pôde ser completada (ver complete_pending_swap):
+      //   o processo não tem como continuar, então é morto (o quadro
+      //   reservado para a transferência é liberado com a memória dele)
+      console_printf("SO: processo %d morto: a página não pôde ser trazida do disco", proc->pid);
+      proc->ctx_cpu.erro = ERR_PAG_AUSENTE;
+      so_acorda_processos_esperando(self, proc);
+      proc->usando = 0;
+      so_muda_estado(self, proc, P_TERMINOU);
+      esc_terminou(self->escalonador, proc);
+      so_libera_memoria_do_processo(self, proc);
+      libera_terminal(self, proc);
+      // sai da fila de bloqueados e espera a limpeza
+      enfileira(self->fila_terminados, proc);
+      continue;
+    }
+    console_printf("SO: swap completo para pid %d, desbloqueando.", proc->pid);
   }
 }
 
@@ -313,37 +431,17 @@ static void so_trata_pendencias(so_t *self)
 {
     // na função que trata de pendências, o SO deve verificar o estado dos dispositivos
   // que causaram bloqueio e realizar operações pendentes e desbloquear processos se for o caso
-  // ver os dispsitivos que podem estar bloqueados, itera por todos os processos
-  for (int i = 0; i < MAX_PROCESSES; i++)
+  // cada causa de bloqueio tem a sua fila; aqui só são vistos os processos
+  //   que esperam o disco ou um dispositivo de E/S
+  so_completa_transferencias(self);
+
+  pcb *prox;
+  for (pcb *proc = fila_primeiro(self->fila_bloqueados_es); proc != NULL; proc = prox)
   {
-    pcb *proc = self->tabela_de_processos[i];
-    //só importa os processos bloqueados por E/S
-    if (proc == NULL || proc->estado != P_BLOQUEADO || proc->dispositivo_bloqueado == -1) {
-      // Também verifica se o bloqueio é por E/S e não por espera de processo (pid_esperando)
-      if (proc != NULL && proc->pid_esperando != -1) continue; 
-      
-      continue; 
-    }
-    // processo [i] está bloqueado em um dispositivo, checar
+    prox = proc->prox_fila; // o processo pode sair da fila
     dispositivo_id_t disp = proc->dispositivo_bloqueado;
     dispositivo_id_t disp_ok = disp + 1;
 
-    // caso especial: bloqueio por disco (transferência de página)
-    if (disp == DISCO_BLOQUEIO) {
-      console_printf("========= BLOQUEIO POR DISCO - VERIFICAR SWAP PENDENTE   %d", proc->pid);
-        int agora = so_tempo_total(self);
-        if (proc->swap_pendente) {
-            if (agora >= proc->desbloqueio_ate) {
-                complete_pending_swap(self, proc);
-                console_printf("SO: swap completo para pid %d, desbloqueando.", proc->pid);
-          
-            }
-            // se swap ainda não terminou, processo permanece bloqueado; 
-            
-        }
-        continue; // passa para o próximo processo da lista
-    }
-
     int estado;
     if (es_le(self->es, disp_ok, &estado) != ERR_OK)
     {
@@ -389,7 +487,8 @@ static void so_trata_pendencias(so_t *self)
       //proc->estado = P_PRONTO;
       so_muda_estado(self, proc, P_PRONTO); // usa a função que contabiliza métricas
       proc->dispositivo_bloqueado = -1; // marca que não está mais esperando E/S
-      enfileira(self->fila_prontos, proc->pid); // coloca na fila de prontos
+      esc_desbloqueou(self->escalonador, proc);
+      so_torna_pronto(self, proc); // coloca entre os prontos
     }
   }
     
@@ -397,66 +496,63 @@ static void so_trata_pendencias(so_t *self)
 }
 
 
-//escalonador round robin
+// escalonador: a escolha do próximo processo é da política (ver
+//   escalonador.h); aqui ficam a limpeza dos processos terminados e a troca
+//   do processo corrente
+
+// entrega ao escalonador um processo que ficou pronto; as filas de
+//   bloqueados são do SO, então o processo sai da que estiver antes (a
+//   política pode guardar os prontos em outra estrutura que não uma fila)
+static void so_torna_pronto(so_t *self, pcb *proc)
+{
+  fila_retira(proc);
+  esc_pronto(self->escalonador, proc);
+}
+
 static void so_escalona(so_t *self)
 {
-    //limpa processos terminados
-  for (int i = 0; i < MAX_PROCESSES; i++)
+  //limpa processos terminados
+  pcb *proc;
+  while ((proc = desenfileira(self->fila_terminados)) != NULL)
   {
-    pcb *proc = self->tabela_de_processos[i];
-    if (proc != NULL && proc->estado == P_TERMINOU)
-    {
-      libera_terminal(self, proc->pid);
-      
-      //salva métricas 
-      so_salva_metricas_finais(self, proc); 
+    libera_terminal(self, proc);
 
-      free(proc);
-      self->tabela_de_processos[i] = NULL;
-    }
+    //salva métricas 
+    so_salva_metricas_finais(self, proc); 
+
+    tabproc_remove(self->tabela_de_processos, proc);
+    free(proc);
   }
 
   // verifica se o processo corrente pode continuar
-  pcb *proc_atual = (self->processo_corrente == NO_PROCESS) ? 
-    NULL : self->tabela_de_processos[self->processo_corrente];
+  pcb *proc_atual = so_proc_corrente(self);
 
   if (proc_atual != NULL && proc_atual->estado == P_EXECUTANDO)
   {
-    return; //deixa ele continuar
+    if (!esc_preempta(self->escalonador, proc_atual)) {
+      return; //deixa ele continuar
+    }
+    // perde a CPU para um processo mais prioritário, mas continua com o
+    //   que sobrou do quantum
+    console_printf("SO: processo %d perdeu a CPU para um mais prioritário", proc_atual->pid);
+    self->metricas->trocas_por_prioridade++;
+    so_muda_estado(self, proc_atual, P_PRONTO);
+    so_torna_pronto(self, proc_atual);
+    self->processo_corrente = NO_PROCESS;
   }
 
-  //procura por um processo pronto na fila
-  while (!fila_vazia(self->fila_prontos))
+  //pede o próximo processo ao escalonador
+  // cada processo sabe o seu lugar na tabela: escolher não depende do
+  //   tamanho da tabela
+  pcb *proc_escolhido;
+  while ((proc_escolhido = esc_proximo(self->escalonador)) != NULL)
   {
-    //pega o primeiro da fila
-    int escolhido_pid = self->fila_prontos->inicio->pid;
-    desenfileira(self->fila_prontos, escolhido_pid); // remove da fila
-
-    // acha o PCB desse processo
-    pcb *proc_escolhido = NULL;
-    int indice_escolhido = -1;
-    for (int i = 0; i < MAX_PROCESSES; i++)
-    {
-      if (self->tabela_de_processos[i] != NULL &&
-        self->tabela_de_processos[i]->pid == escolhido_pid)
-      {
-        proc_escolhido = self->tabela_de_processos[i];
-        indice_escolhido = i;
-        break;
-      }
-    }
-
-    // se o processo não existe mais (foi terminado e limpo), ignora
-    if (proc_escolhido == NULL) {
-      continue; // próximo da fila
-    }
-
     if (proc_escolhido->estado == P_PRONTO) {
         //processo está pronto para rodar, deve ser escolhido
-        console_printf("====> processo %d escolhido \n", escolhido_pid);
-        imprime_fila(self->fila_prontos);
+        console_printf("====> processo %d escolhido \n", proc_escolhido->pid);
+        esc_imprime(self->escalonador);
 
-        self->processo_corrente = indice_escolhido;
+        self->processo_corrente = proc_escolhido->indice;
         
         // usa a função de métrica
         so_muda_estado(self, proc_escolhido, P_EXECUTANDO);
@@ -464,10 +560,8 @@ static void so_escalona(so_t *self)
         return;
     }
     
-    // NÃO. Este processo estava na fila, mas está BLOQUEADO
-    //    (devido ao bug de 'desenfileira' não ser chamado antes).
-    //    Apenas ignore-o (ele já foi removido da fila ).
-    //    O loop 'while' vai pegar o próximo.
+    // um processo que não está pronto não deveria estar na fila;
+    //    é só ignorado (já saiu da fila), e o loop pega o próximo.
   }
 
   // se o loop terminou, a fila de prontos está vazia (ou só tinha lixo)
@@ -490,20 +584,20 @@ static int so_despacha(so_t *self)
     // nenhum processo para rodar
     return 1;
   }
-  cpu_ctx contexto = self->tabela_de_processos[self->processo_corrente]->ctx_cpu;
+  cpu_ctx contexto = so_proc_corrente(self)->ctx_cpu;
   mem_escreve(self->mem, CPU_END_PC, contexto.pc);
   mem_escreve(self->mem, CPU_END_A, contexto.regA);
   mem_escreve(self->mem, 59, contexto.regX);
   mem_escreve(self->mem, CPU_END_erro, contexto.erro);
   mem_escreve(self->mem, CPU_END_complemento, contexto.complemento); // limpa complemento
   // define a tabela de páginas do processo corrente na MMU
-  mmu_define_tabpag(self->mmu, self->tabela_de_processos[self->processo_corrente]->tabela_paginas);
+  mmu_define_tabpag(self->mmu, so_proc_corrente(self)->tabela_paginas);
 
   int q;
-  int err = tabpag_traduz(self->tabela_de_processos[self->processo_corrente]->tabela_paginas, contexto.pc/TAM_PAGINA, &q);
+  int err = tabpag_traduz(so_proc_corrente(self)->tabela_paginas, contexto.pc/TAM_PAGINA, &q);
   console_printf("Espero ler instrução do quadro físico %d, traduzido da página virtual %d", q, contexto.pc/TAM_PAGINA);
   console_printf("Erro foi: %d. ERR_OK é %d", err, ERR_OK);
-  console_printf("Processo = #%d", self->tabela_de_processos[self->processo_corrente]->pid);
+  console_printf("Processo = #%d", so_proc_corrente(self)->pid);
 
   if (self->erro_interno)
     return 1;
@@ -513,12 +607,211 @@ static int so_despacha(so_t *self)
 }
 
 static int pag_livre(so_t *self) {
-    for (size_t i = BLOCOS_RESERVADOS; i < self->num_paginas_fisicas; i++) {
-        if (!self->blocos_memoria[i].ocupado) {
-            return i;
-        }
-    }
-    return -1; // Nenhuma página livre
+    // o mapa de quadros livres dá o de menor número
+    return quadros_livres_primeiro(self->quadros_livres); // -1 se nenhum livre
+}
+
+// marca o quadro como ocupado/livre no controle de blocos e no mapa de livres
+static void so_ocupa_quadro(so_t *self, int quadro) {
+  self->blocos_memoria[quadro].ocupado = true;
+  quadros_livres_ocupa(self->quadros_livres, quadro);
+}
+
+static void so_libera_quadro(so_t *self, int quadro) {
+  self->blocos_memoria[quadro].ocupado = false;
+  quadros_livres_libera(self->quadros_livres, quadro);
+}
+
+// PÁGINAS COMPARTILHADAS
+// as páginas de um processo são as da imagem do seu programa, compartilhada
+//   com os outros processos que executam o mesmo programa (ver imagem.h), até
+//   o processo escrever nelas; a partir daí, o processo tem uma cópia da
+//   página, em um quadro seu e em uma página própria da memória secundária
+// a cópia pode ser compartilhada com processos clonados; enquanto for, ou
+//   enquanto estiver em um quadro compartilhado, ela é tratada como as
+//   páginas da imagem
+// um quadro compartilhado pode estar mapeado em vários processos, sempre
+//   protegido contra escrita
+
+// retorna a cópia da página do processo (NULL se é a da imagem)
+static copia_t *so_copia(pcb *proc, int pagina)
+{
+  if (proc->copias == NULL || pagina < 0 || pagina >= proc->num_paginas) return NULL;
+  return proc->copias[pagina];
+}
+
+// retorna true se a página do processo fica em um quadro compartilhado
+static bool so_pagina_compartilhada(pcb *proc, int pagina)
+{
+  if (proc->imagem == NULL || pagina < 0 || pagina >= proc->num_paginas) return false;
+  copia_t *copia = proc->copias[pagina];
+  return copia == NULL || copia->refs > 1 || copia->quadro >= 0;
+}
+
+// retorna o quadro compartilhado que tem a página do processo (-1 se não tem)
+static int so_quadro_compartilhado(pcb *proc, int pagina)
+{
+  if (!so_pagina_compartilhada(proc, pagina)) return -1;
+  copia_t *copia = proc->copias[pagina];
+  return copia == NULL ? proc->imagem->quadros[pagina] : copia->quadro;
+}
+
+// o quadro passa a ser o compartilhado da página do processo
+static void so_compartilha_quadro(so_t *self, pcb *proc, int pagina, int quadro)
+{
+  copia_t *copia = proc->copias[pagina];
+  donos_quadros_associa_imagem(self->donos_quadros, quadro, proc->imagem, pagina, copia);
+  if (copia == NULL) proc->imagem->quadros[pagina] = quadro;
+  else copia->quadro = quadro;
+}
+
+// o quadro deixa de ser compartilhado (só a imagem ou a cópia esquecem dele)
+static void so_descompartilha_quadro(so_t *self, int quadro)
+{
+  copia_t *copia = self->donos_quadros->copia[quadro];
+  if (copia != NULL) {
+    copia->quadro = -1;
+  } else {
+    int pg = self->donos_quadros->pg[quadro];
+    self->donos_quadros->imagem[quadro]->quadros[pg] = -1;
+  }
+}
+
+// retorna o endereço da página do processo na memória secundária
+static int so_end_disco_pagina(pcb *proc, int pagina)
+{
+  copia_t *copia = so_copia(proc, pagina);
+  if (copia != NULL) return copia->pagina_disco * TAM_PAGINA;
+  return proc->end_disco + pagina * TAM_PAGINA;
+}
+
+static bool so_tem_mapeado(pcb *proc, int pagina, int quadro)
+{
+  int q;
+  return tabpag_traduz(proc->tabela_paginas, pagina, &q) == ERR_OK && q == quadro;
+}
+
+// retorna o próximo processo depois de 'proc' (o primeiro, se 'proc' for
+//   NULL) que tem a página do quadro mapeada, ou NULL se não tiver mais
+// um quadro de processo só pode estar mapeado no dono; um compartilhado, em
+//   qualquer um dos processos que usam a imagem
+static pcb *so_proximo_mapeamento(so_t *self, int quadro, pcb *proc)
+{
+  int pg = self->donos_quadros->pg[quadro];
+  imagem_t *img = self->donos_quadros->imagem[quadro];
+  if (img == NULL) {
+    pcb *dono = self->donos_quadros->dono[quadro];
+    if (proc != NULL || dono == NULL || !so_tem_mapeado(dono, pg, quadro)) return NULL;
+    return dono;
+  }
+  for (pcb *p = proc == NULL ? img->usuarios : proc->prox_usuario; p != NULL; p = p->prox_usuario) {
+    if (so_tem_mapeado(p, pg, quadro)) return p;
+  }
+  return NULL;
+}
+
+// os bits de acesso e alteração de um quadro são os das páginas mapeadas nele
+static bool so_quadro_acessado(so_t *self, int quadro)
+{
+  int pg = self->donos_quadros->pg[quadro];
+  for (pcb *p = so_proximo_mapeamento(self, quadro, NULL); p != NULL;
+       p = so_proximo_mapeamento(self, quadro, p)) {
+    if (tabpag_bit_acesso(p->tabela_paginas, pg)) return true;
+  }
+  return false;
+}
+
+// um quadro compartilhado não pode ser escrito, mas o de uma cópia pode ter
+//   sido alterado antes de ser compartilhado
+static bool so_quadro_alterado(so_t *self, int quadro)
+{
+  copia_t *copia = self->donos_quadros->copia[quadro];
+  if (copia != NULL && copia->suja) return true;
+  int pg = self->donos_quadros->pg[quadro];
+  for (pcb *p = so_proximo_mapeamento(self, quadro, NULL); p != NULL;
+       p = so_proximo_mapeamento(self, quadro, p)) {
+    if (tabpag_bit_alteracao(p->tabela_paginas, pg)) return true;
+  }
+  return false;
+}
+
+static void so_quadro_zera_acesso(so_t *self, int quadro)
+{
+  int pg = self->donos_quadros->pg[quadro];
+  for (pcb *p = so_proximo_mapeamento(self, quadro, NULL); p != NULL;
+       p = so_proximo_mapeamento(self, quadro, p)) {
+    tabpag_zera_bit_acesso(p->tabela_paginas, pg);
+    mmu_invalida_pagina(self->mmu, p->tabela_paginas, pg);
+  }
+}
+
+// mapeia a página no quadro, na tabela do processo, já marcada como acessada
+//   (o acesso que causou a falta vai ser refeito; senão o CLOCK pode escolher a
+//   página antes do processo voltar a executar); páginas da imagem
+//   compartilhada são mapeadas sem permissão de escrita, para que a primeira
+//   escrita cause ERR_PAG_PROTEGIDA (ver so_trata_escrita_protegida)
+// código e dados dos programas ficam misturados nas mesmas páginas, então
+//   todas as páginas podem ser lidas e executadas
+static void so_mapeia_pagina(so_t *self, pcb *proc, int pagina, int quadro)
+{
+  tabpag_t *tab = proc->tabela_paginas;
+  tabpag_define_quadro(tab, pagina, quadro);
+  if (so_pagina_compartilhada(proc, pagina)) {
+    tabpag_define_permissao(tab, pagina, TABPAG_LEITURA | TABPAG_EXECUCAO);
+  }
+  mmu_invalida_pagina(self->mmu, tab, pagina);
+  tabpag_marca_bit_acesso(tab, pagina, false);
+  self->donos_quadros->idade[quadro] = (1u << 31);
+}
+
+// o processo passa a executar o programa da imagem, ainda sem cópias
+static void so_usa_imagem(so_t *self, pcb *proc, imagem_t *img)
+{
+  imagem_acrescenta_usuario(img, proc);
+  proc->imagem = img;
+  proc->end_disco = img->pagina_disco * TAM_PAGINA;
+  proc->num_paginas = img->num_paginas;
+  proc->copias = calloc(img->num_paginas, sizeof(*proc->copias));
+  assert(proc->copias != NULL);
+}
+
+// o processo deixa de usar a cópia; se era o último, a cópia é destruída,
+//   liberando o seu quadro compartilhado (se tiver) e a memória secundária
+// o quadro de uma cópia só do processo está na lista dele, e é liberado com ela
+static void so_solta_copia(so_t *self, copia_t *copia)
+{
+  if (--copia->refs > 0) return;
+  if (copia->quadro >= 0) {
+    donos_quadros_desassocia(self->donos_quadros, copia->quadro);
+    so_libera_quadro(self, copia->quadro);
+  }
+  mapa_disco_libera(self->mapa_disco, copia->pagina_disco, 1);
+  free(copia);
+}
+
+// o processo deixa de usar a sua imagem e as suas cópias; se era o último
+//   usuário, a imagem sai do cache, liberando os seus quadros e a memória
+//   secundária que ocupava
+static void so_solta_imagem(so_t *self, pcb *proc)
+{
+  imagem_t *img = proc->imagem;
+  if (img == NULL) return;
+  for (int pg = 0; pg < proc->num_paginas; pg++) {
+    if (proc->copias[pg] != NULL) so_solta_copia(self, proc->copias[pg]);
+  }
+  free(proc->copias);
+  proc->copias = NULL;
+  imagem_retira_usuario(img, proc);
+  proc->imagem = NULL;
+  if (img->refs > 0) return;
+  for (int pg = 0; pg < img->num_paginas; pg++) {
+    int quadro = img->quadros[pg];
+    if (quadro < 0) continue;
+    donos_quadros_desassocia(self->donos_quadros, quadro);
+    so_libera_quadro(self, quadro);
+  }
+  mapa_disco_libera(self->mapa_disco, img->pagina_disco, img->num_paginas);
+  imagens_remove(self->imagens, img);
 }
 
 //////////////// ALGORITIMOS DE SUBSTITUIÇÃO DE PÁGINAS /////////////////
@@ -537,6 +830,8 @@ static int escolhe_pagina_fifo(so_t *self) {
     // considerar SOMENTE quadros ocupados (só estes fazem sentido para substituição)
     for (int i = BLOCOS_RESERVADOS; i < self->num_paginas_fisicas; i++) {
         if (!self->blocos_memoria[i].ocupado) continue; // ignora quadros livres
+        // ignora quadros reservados para uma transferência ainda não completada
+        if (self->donos_quadros->dono[i] == NULL && self->donos_quadros->imagem[i] == NULL) continue;
         int idade = ciclo_atual - self->blocos_memoria[i].ciclos; // maior = mais antigo
         if (idade > max_ciclos) {
             max_ciclos = idade;
@@ -558,69 +853,96 @@ static void so_envelhece_quadros(so_t *self)
 {
   if (self == NULL) return;
   if (self->blocos_memoria == NULL) return;
-  if (self->processo_corrente == NO_PROCESS) return;
-  if (self->processo_corrente < 0 || self->processo_corrente >= MAX_PROCESSES) return;
-
-  pcb* proc = self->tabela_de_processos[self->processo_corrente];
+  pcb* proc = so_proc_corrente(self);
   if (proc == NULL) return;
   tabpag_t *tab = proc->tabela_paginas;
   if (tab == NULL) return;
 
-  const uint32_t MSB = 1u << (8 * sizeof(uint32_t) - 1); // bit mais significativo
-  int start = BLOCOS_RESERVADOS;
-  if (start < 0) start = 0;
-  if (start >= self->num_paginas_fisicas) return;
-
-  for (int i = start; i < self->num_paginas_fisicas; ++i){
-    // pular quadros livres e quadros do SO / reservados
-    if (!self->blocos_memoria[i].ocupado) continue;
-    int pid = self->blocos_memoria[i].pid;
-    if (pid != proc->pid) continue; // só envelhece quadros do processo corrente
-
-    int pg_virt = self->blocos_memoria[i].pg;
-    if (pg_virt < 0) continue;
-    uint32_t antes = self->blocos_memoria[i].acesso;
-    // shift right do contador
-    self->blocos_memoria[i].acesso >>= 1;
-    // se a página foi acessada (tabpag_bit_acesso), seta MSB e zera o bit
-    if (tabpag_bit_acesso(tab, pg_virt)){
-      self->blocos_memoria[i].acesso |= MSB;
-      tabpag_zera_bit_acesso(tab, pg_virt);
-       console_printf("ENVELHECE: Q=%d pid=%d pg=%d acesso antes=0x%08x depois=0x%08x bit_acesso=%d", i, pid, pg_virt, antes, self->blocos_memoria[i].acesso);
-    }
+  // recolhe os bits de acesso das páginas do processo (zerando-os) no mapa
+  //   de quadros acessados, e envelhece de uma vez todos os quadros do processo
+  if (tabpag_coleta_acessos(tab, self->donos_quadros->acessados) > 0) {
+    // as entradas da TLB têm o bit de acesso ligado
+    mmu_invalida_tabpag(self->mmu, tab);
   }
+  donos_quadros_envelhece(self->donos_quadros, proc->pid);
 }
 
 static int escolhe_pagina_lru(so_t *self) {
-  uint32_t menor_val = UINT32_MAX;
-  int escolhido = -1;
-  for (int i = BLOCOS_RESERVADOS; i < self->num_paginas_fisicas; ++i){
-    if (!self->blocos_memoria[i].ocupado)
-      continue;
-    if (self->blocos_memoria[i].pid <= 0)
-      continue; // pular SO
-    if (self->blocos_memoria[i].pg < 0)
-      continue;
-    uint32_t v = self->blocos_memoria[i].acesso;
-    if (v < menor_val){
-      menor_val = v;
-      escolhido = i;
-      console_printf("LRU: candidato Q=%d pid=%d pg=%d acesso=0x%08x ciclos=%d", i, self->blocos_memoria[i].pid, self->blocos_memoria[i].pg, self->blocos_memoria[i].acesso, self->blocos_memoria[i].ciclos);
-    }
-    console_printf("LRU: escolhido Q=%d pid=%d pg=%d acesso=0x%08x", escolhido, self->blocos_memoria[escolhido].pid, self->blocos_memoria[escolhido].pg, self->blocos_memoria[escolhido].acesso);
+  // só quadros de processos (pid > 0) têm dono; os do SO e os livres não
+  int escolhido = donos_quadros_menor_idade(self->donos_quadros);
+  if (escolhido >= 0) {
+    console_printf("LRU: escolhido Q=%d pid=%d pg=%d acesso=0x%08x", escolhido, self->donos_quadros->pid[escolhido], self->donos_quadros->pg[escolhido], self->donos_quadros->idade[escolhido]);
   }
   return escolhido;
 }
 
+// CLOCK (segunda chance): os quadros formam um círculo, percorrido por um
+//   ponteiro. A página no quadro apontado é escolhida se não foi acessada;
+//   se foi, o bit de acesso é zerado (ela ganha uma segunda chance) e o
+//   ponteiro avança. O ponteiro continua de onde parou na próxima escolha,
+//   então o custo médio por falta de página é constante.
+// na versão melhorada, as páginas não alteradas são preferidas (não precisam
+//   ser gravadas no disco): a primeira volta procura uma página não acessada
+//   nem alterada, sem zerar nada; a segunda procura uma não acessada e
+//   alterada, zerando os bits de acesso das que passam; e assim por diante.
+
+// avança o ponteiro do relógio para o próximo quadro
+static void avanca_ponteiro_relogio(so_t *self) {
+  self->ponteiro_relogio++;
+  if (self->ponteiro_relogio >= self->num_paginas_fisicas) {
+    self->ponteiro_relogio = BLOCOS_RESERVADOS;
+  }
+}
+
+// retorna false se o quadro não pode ser escolhido (livre, do SO, ou
+//   reservado para uma transferência)
+static bool so_quadro_substituivel(so_t *self, int quadro) {
+  if (!self->blocos_memoria[quadro].ocupado) return false;
+  if (self->donos_quadros->dono[quadro] == NULL && self->donos_quadros->imagem[quadro] == NULL) return false;
+  return self->donos_quadros->pg[quadro] >= 0;
+}
+
+static int escolhe_pagina_relogio(so_t *self, bool melhorado) {
+  int n_quadros = self->num_paginas_fisicas - BLOCOS_RESERVADOS;
+  if (n_quadros <= 0) return -1;
+  // no pior caso, a versão simples precisa de 2 voltas (a primeira zera
+  //   todos os bits de acesso) e a melhorada de 4
+  int n_voltas = melhorado ? 4 : 2;
+  for (int volta = 0; volta < n_voltas; volta++) {
+    for (int n = 0; n < n_quadros; n++) {
+      int quadro = self->ponteiro_relogio;
+      avanca_ponteiro_relogio(self);
+      if (!so_quadro_substituivel(self, quadro)) continue;
+      bool acessada = so_quadro_acessado(self, quadro);
+      if (melhorado) {
+        bool alterada = so_quadro_alterado(self, quadro);
+        bool procura_alterada = (volta % 2 == 1);
+        if (!acessada && alterada == procura_alterada) return quadro;
+        // só zera o acesso na volta que procura páginas alteradas
+        if (!procura_alterada) continue;
+      } else if (!acessada) {
+        return quadro;
+      }
+      // segunda chance
+      so_quadro_zera_acesso(self, quadro);
+    }
+  }
+  return -1;
+}
+
 //////////////////////////////// ////////////////////////////////////////
 
 static int escolher_alg_subst(so_t *self){
   switch (ALG_SUBSTITUICAO)
   {
-  case 0:
+  case ALG_FIFO:
     return escolhe_pagina_fifo(self);
-  case 1:
+  case ALG_LRU:
     return escolhe_pagina_lru(self);
+  case ALG_RELOGIO:
+    return escolhe_pagina_relogio(self, false);
+  case ALG_RELOGIO_MELHORADO:
+    return escolhe_pagina_relogio(self, true);
   default:
     console_printf("SO: algoritmo de substituição de páginas inválido");
     self->erro_interno = true;
@@ -628,17 +950,138 @@ static int escolher_alg_subst(so_t *self){
   }
 }
 
+/* tira do quadro a página que está nele (se tiver), gravando-a no disco se
+   foi alterada. É feito quando o quadro é reservado para uma transferência, e
+   não quando ela completa: sem dono, o quadro não pode ser escolhido de novo
+   para substituição por outra falta enquanto a transferência não termina.
+   Coloca em *gravou se a página precisou ser gravada.
+   Retorna false em caso de erro. */
+static bool so_esvazia_quadro(so_t *self, int quadro, bool *gravou)
+{
+  *gravou = false;
+  int pid_do_bloco = self->donos_quadros->pid[quadro];
+  if (pid_do_bloco == PID_IMAGEM)
+  {
+    /* quadro compartilhado: não pode ser escrito (a escrita faz uma cópia),
+       só sai das tabelas dos processos que o mapeiam; uma cópia pode ter
+       sido alterada antes de ser compartilhada, e aí é gravada */
+    int pg = self->donos_quadros->pg[quadro];
+    copia_t *copia = self->donos_quadros->copia[quadro];
+    if (copia != NULL && copia->suja)
+    {
+      console_printf("SO: swap-out: escrevendo cópia compartilhada da pag %d para disco (Q %d)", pg, quadro);
+      if (mem_copia(self->mem_sec, copia->pagina_disco * TAM_PAGINA, self->mem, quadro * TAM_PAGINA, TAM_PAGINA) != ERR_OK)
+      {
+        console_printf("SO: erro copiando Q %d para mem_sec durante swap-out", quadro);
+        self->erro_interno = true;
+        return false;
+      }
+      copia->suja = false;
+      *gravou = true;
+      self->metricas->gravacoes_substituicao++;
+    }
+    for (pcb *p = so_proximo_mapeamento(self, quadro, NULL); p != NULL;
+         p = so_proximo_mapeamento(self, quadro, p)) {
+      tabpag_invalida_pagina(p->tabela_paginas, pg);
+      mmu_invalida_pagina(self->mmu, p->tabela_paginas, pg);
+    }
+    so_descompartilha_quadro(self, quadro);
+  }
+  else if (pid_do_bloco > 0)
+  {
+    /* a tabela invertida dá o processo e a página que estão no quadro */
+    pcb *proc_sai = self->donos_quadros->dono[quadro];
+    int pg_virt_sai = self->donos_quadros->pg[quadro];
+    if (proc_sai != NULL && pg_virt_sai >= 0)
+    {
+      tabpag_t *tab_pag_sai = proc_sai->tabela_paginas;
+      int end_disco_sai = so_end_disco_pagina(proc_sai, pg_virt_sai);
+      /* se era uma página lida adiantada e ainda não usada, não está mapeada */
+      so_desperdica_pagina_adiantada(self, proc_sai, pg_virt_sai);
+      /* se página foi alterada, grava no disco */
+      if (tabpag_bit_alteracao(tab_pag_sai, pg_virt_sai))
+      {
+        console_printf("SO: swap-out: escrevendo pag %d PID %d para disco (Q %d)", pg_virt_sai, proc_sai->pid, quadro);
+        if (mem_copia(self->mem_sec, end_disco_sai, self->mem, quadro * TAM_PAGINA, TAM_PAGINA) != ERR_OK)
+        {
+          console_printf("SO: erro copiando Q %d para mem_sec em addr %d durante swap-out", quadro, end_disco_sai);
+          self->erro_interno = true;
+          return false;
+        }
+        *gravou = true;
+        self->metricas->gravacoes_substituicao++;
+      }
+      /* invalidar a entrada antiga da tabela do processo que estava no quadro */
+      tabpag_invalida_pagina(tab_pag_sai, pg_virt_sai);
+      mmu_invalida_pagina(self->mmu, tab_pag_sai, pg_virt_sai);
+    }
+    else
+    {
+      /* se não achar o processo dono, avisar (mas continuar com o swap-in) */
+      console_printf("SO: swap-out aviso: PID do bloco %d não encontrado ou pg inválida", pid_do_bloco);
+    }
+  }
+
+  donos_quadros_desassocia(self->donos_quadros, quadro);
+  return true;
+}
+
+// LIMPADOR DE PÁGINAS
+// uma página alterada escolhida para substituição precisa ser gravada no
+//   disco antes de a nova ser lida, o que dobra o tempo da falta. A cada
+//   interrupção de relógio, se o disco estiver ocioso, o limpador grava
+//   algumas páginas alteradas que devem ser substituídas em breve (as não
+//   acessadas recentemente; no FIFO o acesso não conta, qualquer uma serve)
+//   e zera o bit de alteração delas, para que a substituição as encontre limpas.
+// o limpador percorre os quadros circularmente, examinando no máximo
+//   LIMPEZA_EXAMINADOS quadros e gravando no máximo LIMPEZA_GRAVADOS por vez;
+//   cada gravação ocupa o disco como uma transferência de página.
+// enquanto houver mais de LIMPEZA_LIVRES quadros livres, nenhuma página vai ser
+//   substituída tão cedo, e o limpador não faz nada.
+#define LIMPEZA_EXAMINADOS 16
+#define LIMPEZA_GRAVADOS 2
+#define LIMPEZA_LIVRES 8
+
+static void so_limpa_paginas(so_t *self)
+{
+  if (quadros_livres_num(self->quadros_livres) > LIMPEZA_LIVRES) return;
+  int agora = so_tempo_total(self);
+  // só usa o disco se ninguém estiver esperando por ele
+  if (self->disco_livre_ate > agora) return;
+  int gravados = 0;
+  for (int n = 0; n < LIMPEZA_EXAMINADOS && gravados < LIMPEZA_GRAVADOS; n++) {
+    int quadro = self->ponteiro_limpeza;
+    self->ponteiro_limpeza++;
+    if (self->ponteiro_limpeza >= self->num_paginas_fisicas) {
+      self->ponteiro_limpeza = BLOCOS_RESERVADOS;
+    }
+    pcb *dono = self->donos_quadros->dono[quadro];
+    int pg = self->donos_quadros->pg[quadro];
+    if (dono == NULL || pg < 0) continue;
+    tabpag_t *tab = dono->tabela_paginas;
+    if (!tabpag_bit_alteracao(tab, pg)) continue;
+    if (ALG_SUBSTITUICAO != ALG_FIFO && tabpag_bit_acesso(tab, pg)) continue;
+    int end_disco = so_end_disco_pagina(dono, pg);
+    if (mem_copia(self->mem_sec, end_disco, self->mem, quadro * TAM_PAGINA, TAM_PAGINA) != ERR_OK) {
+      console_printf("SO: limpador: erro copiando Q %d para mem_sec em addr %d", quadro, end_disco);
+      self->erro_interno = true;
+      return;
+    }
+    // a TLB guarda o bit de alteração; a próxima escrita tem que ligá-lo de novo
+    tabpag_zera_bit_alteracao(tab, pg);
+    mmu_invalida_pagina(self->mmu, tab, pg);
+    gravados++;
+    self->disco_livre_ate = agora + gravados * self->tempo_transfer_pagina;
+    self->metricas->gravacoes_limpador++;
+  }
+}
+
 /* agenda uma transferência de página (swap-in) para o processo proc;
    end_causador é o endereço virtual que causou o page fault (complemento).
    pg_dest: índice do quadro físico reservado (se -1, tenta obter um livre).
    Esta função reserva o quadro e bloqueia o processo até fim_transfer. */
 static void schedule_page_transfer(so_t *self, pcb *proc, int end_causador, int pg_dest)
 {
-  int agora = so_tempo_total(self);
-  int inicio_transfer = (self->disco_livre_ate > agora) ? self->disco_livre_ate : agora;
-  int fim_transfer = inicio_transfer + self->tempo_transfer_pagina;
-  self->disco_livre_ate = fim_transfer; // reserva o disco até fim_transfer
-
   /* se pg_dest < 0, tenta alocar quadro livre; se não houver, escolhe vítima */
   if (pg_dest < 0)
   {
@@ -667,7 +1110,17 @@ static void schedule_page_transfer(so_t *self, pcb *proc, int end_causador, int
   }
 
   /* reserva o quadro para evitar racing (marca ocupado provisoriamente) */
-  self->blocos_memoria[pg_dest].ocupado = true;
+  bool gravou;
+  if (!so_esvazia_quadro(self, pg_dest, &gravou)) return;
+  so_ocupa_quadro(self, pg_dest);
+
+  /* a transferência começa quando o disco terminar o que já foi agendado;
+     se a página que sai do quadro foi gravada, são duas operações */
+  int agora = so_tempo_total(self);
+  int inicio_transfer = (self->disco_livre_ate > agora) ? self->disco_livre_ate : agora;
+  int fim_transfer = inicio_transfer + self->tempo_transfer_pagina;
+  if (gravou) fim_transfer += self->tempo_transfer_pagina;
+  self->disco_livre_ate = fim_transfer; // reserva o disco até fim_transfer
 
   /* grava informações no PCB */
   proc->swap_pendente = 1;
@@ -680,6 +1133,8 @@ static void schedule_page_transfer(so_t *self, pcb *proc, int end_causador, int
 
   /* bloqueia o processo e força escalonador escolher outro */
   so_muda_estado(self, proc, P_BLOQUEADO);
+  esc_bloqueou(self->escalonador, proc);
+  enfileira(self->fila_bloqueados_disco, proc);
   self->processo_corrente = NO_PROCESS;
 
   console_printf("SO: agendada transferência PID %d end %d -> Q %d (bloqueado até %d)",
@@ -698,103 +1153,63 @@ static void complete_pending_swap(so_t *self, pcb *proc)
   /* VALIDAÇÃO: quadro dentro do intervalo de quadros físicos */
   if (quadro < 0 || quadro >= self->num_paginas_fisicas)
   {
-    console_printf("SO: ERRO: quadro inválido em complete_pending_swap: %d (num=%d). Limpando pendência.",
+    console_printf("SO: ERRO: quadro inválido em complete_pending_swap: %d (num=%d).",
                    quadro, self->num_paginas_fisicas);
-    /* limpar pendência para evitar loop infinito */
-    proc->swap_pendente = 0;
+    /* não há quadro reservado a liberar; o processo continua na fila de
+       bloqueados, e so_completa_transferencias mata ele */
     proc->pending_swap_quadro = -1;
-    proc->pending_swap_end_causador = -1;
-    proc->desbloqueio_ate = -1;
-    proc->dispositivo_bloqueado = -1;
     return;
   }
 
-  int end_disc_ini = proc->end_disco + inicio_pagina_virtual;
+  int pagina = inicio_pagina_virtual / TAM_PAGINA;
+  int end_disc_ini = so_end_disco_pagina(proc, pagina);
   int memsec_tam = mem_tam(self->mem_sec);
   if (proc->end_disco < 0 || end_disc_ini < 0 || (end_disc_ini + TAM_PAGINA) > memsec_tam)
   {
-    console_printf("SO: ERRO: endereço inválido em mem_sec para PID %d: end_disco=%d, inicio_pag=%d, memsec_tam=%d. Limpando pendência.",
+    console_printf("SO: ERRO: endereço inválido em mem_sec para PID %d: end_disco=%d, inicio_pag=%d, memsec_tam=%d.",
                    proc->pid, proc->end_disco, inicio_pagina_virtual, memsec_tam);
-    proc->swap_pendente = 0;
-    proc->pending_swap_quadro = -1;
-    proc->pending_swap_end_causador = -1;
-    proc->desbloqueio_ate = -1;
-    proc->dispositivo_bloqueado = -1;
+    /* o quadro reservado continua na pendência, e é liberado quando
+       so_completa_transferencias mata o processo */
     return;
   }
 
-  /* Trata sempre o conteúdo anterior do quadro, mesmo que pertença ao mesmo PID */
-  int pid_do_bloco = self->blocos_memoria[quadro].pid;
-  if (pid_do_bloco > 0)
+  if (so_quadro_compartilhado(proc, pagina) >= 0)
   {
-    pcb *proc_sai = achar_processo(self, pid_do_bloco);
-    int pg_virt_sai = self->blocos_memoria[quadro].pg;
-    if (proc_sai != NULL && pg_virt_sai >= 0)
-    {
-      tabpag_t *tab_pag_sai = proc_sai->tabela_paginas;
-      int end_disco_sai = proc_sai->end_disco + (pg_virt_sai * TAM_PAGINA);
-      /* se página foi alterada, grava no disco */
-      if (tabpag_bit_alteracao(tab_pag_sai, pg_virt_sai))
-      {
-        console_printf("SO: swap-out: escrevendo pag %d PID %d para disco (Q %d)", pg_virt_sai, proc_sai->pid, quadro);
-        for (int off = 0; off < TAM_PAGINA; off++)
-        {
-          int val;
-          if (mem_le(self->mem, quadro * TAM_PAGINA + off, &val) != ERR_OK)
-          {
-            console_printf("SO: erro lendo mem principal em addr %d durante swap-out", quadro * TAM_PAGINA + off);
-            self->erro_interno = true;
-            return;
-          }
-          if (mem_escreve(self->mem_sec, end_disco_sai + off, val) != ERR_OK)
-          {
-            console_printf("SO: erro escrevendo mem_sec em addr %d durante swap-out", end_disco_sai + off);
-            self->erro_interno = true;
-            return;
-          }
-        }
-      }
-      /* invalidar a entrada antiga da tabela do processo que estava no quadro */
-      tabpag_invalida_pagina(tab_pag_sai, pg_virt_sai);
-    }
-    else
-    {
-      /* se não achar o processo dono, avisar (mas continuar com o swap-in) */
-      console_printf("SO: swap-out aviso: PID do bloco %d não encontrado ou pg inválida", pid_do_bloco);
-    }
+    /* outro processo trouxe a mesma página compartilhada enquanto esta
+       transferência acontecia: usa o quadro dele */
+    so_libera_quadro(self, quadro);
+    quadro = so_quadro_compartilhado(proc, pagina);
   }
-
-  /* copia da mem_sec para mem principal (swap-in) */
-  for (int off = 0; off < TAM_PAGINA; off++)
+  else
   {
-    int val;
-    if (mem_le(self->mem_sec, end_disc_ini + off, &val) != ERR_OK)
+    /* copia da mem_sec para mem principal (swap-in) */
+    if (mem_copia(self->mem, quadro * TAM_PAGINA, self->mem_sec, end_disc_ini, TAM_PAGINA) != ERR_OK)
     {
-      console_printf("SO: erro leitura mem_sec em complete_pending_swap addr %d", end_disc_ini + off);
+      console_printf("SO: erro copiando mem_sec addr %d para Q %d em complete_pending_swap", end_disc_ini, quadro);
       self->erro_interno = true;
       return;
     }
-    if (mem_escreve(self->mem, quadro * TAM_PAGINA + off, val) != ERR_OK)
+
+    /* atualiza controle de blocos; a página compartilhada fica em um quadro
+       compartilhado */
+    if (so_pagina_compartilhada(proc, pagina)) {
+      so_compartilha_quadro(self, proc, pagina, quadro);
+    } else {
+      donos_quadros_associa(self->donos_quadros, quadro, proc, pagina);
+    }
+    if (es_le(self->es, D_RELOGIO_INSTRUCOES, &self->blocos_memoria[quadro].ciclos) != ERR_OK)
     {
-      console_printf("SO: erro escrita mem em complete_pending_swap addr %d", quadro * TAM_PAGINA + off);
+      console_printf("SO: erro lendo ciclos ao completar transfer");
       self->erro_interno = true;
-      return;
     }
   }
 
-  /* atualiza controle de blocos e tabela */
-  self->blocos_memoria[quadro].pid = proc->pid;
-  self->blocos_memoria[quadro].pg = inicio_pagina_virtual / TAM_PAGINA;
-  self->blocos_memoria[quadro].acesso = (1u << 31);
-  if (es_le(self->es, D_RELOGIO_INSTRUCOES, &self->blocos_memoria[quadro].ciclos) != ERR_OK)
-  {
-    console_printf("SO: erro lendo ciclos ao completar transfer");
-    self->erro_interno = true;
-  }
-
-  tabpag_define_quadro(proc->tabela_paginas, inicio_pagina_virtual / TAM_PAGINA, quadro);
+  so_mapeia_pagina(self, proc, pagina, quadro);
   mmu_define_tabpag(self->mmu, proc->tabela_paginas);
 
+  /* as páginas seguintes vieram na mesma operação de disco */
+  so_completa_leitura_adiantada(self, proc);
+
   /* limpa flags do PCB */
   proc->swap_pendente = 0;
   proc->pending_swap_quadro = -1;
@@ -808,14 +1223,252 @@ static void complete_pending_swap(so_t *self, pcb *proc)
 
   /* desbloqueia / torna pronto */
   so_muda_estado(self, proc, P_PRONTO);
-  enfileira(self->fila_prontos, proc->pid);
+  so_torna_pronto(self, proc);
   console_printf("SO: transferência completada,  PID %d desbloqueado (Q %d)", proc->pid, quadro);
 }
 
+// LEITURA ADIANTADA
+// os programas costumam causar faltas em páginas consecutivas. Quando uma
+//   falta continua a sequência das anteriores, a transferência da página traz
+//   junto as seguintes, na mesma operação de disco, para quadros livres (nunca
+//   substitui páginas para isso). Essas páginas ficam em uma janela no PCB,
+//   sem estar mapeadas; uma falta em uma delas é resolvida sem ir ao disco
+//   (acerto). As que são substituídas ou descartadas antes de serem usadas são
+//   desperdício.
+// o tamanho da janela se adapta: começa em 1 na primeira falta sequencial e
+//   dobra a cada nova falta sequencial (até MAX_LEITURA_ADIANTADA), volta a 0
+//   quando a sequência é quebrada e cai pela metade a cada desperdício.
+
+// retorna a posição da página na janela de leitura adiantada do processo,
+//   ou -1 se não estiver lá (ou já tiver sido usada ou descartada)
+static int so_indice_adiantada(pcb *proc, int pagina)
+{
+  int i = pagina - proc->pg_adiantada;
+  if (i < 0 || i >= proc->n_adiantadas) return -1;
+  if (proc->quadros_adiantados[i] < 0) return -1;
+  return i;
+}
+
+// libera os quadros das páginas da janela que não foram usadas
+static void so_descarta_leitura_adiantada(so_t *self, pcb *proc)
+{
+  for (int i = 0; i < proc->n_adiantadas; i++) {
+    int quadro = proc->quadros_adiantados[i];
+    if (quadro < 0) continue;
+    // o quadro pode estar só reservado, se a transferência não completou
+    if (self->donos_quadros->dono[quadro] == proc) {
+      donos_quadros_desassocia(self->donos_quadros, quadro);
+    }
+    so_libera_quadro(self, quadro);
+    self->metricas->adiantadas_desperdicadas++;
+  }
+  proc->n_adiantadas = 0;
+}
+
+// a página vai ser substituída; se estiver na janela, foi desperdiçada
+static void so_desperdica_pagina_adiantada(so_t *self, pcb *proc, int pagina)
+{
+  int i = so_indice_adiantada(proc, pagina);
+  if (i < 0) return;
+  proc->quadros_adiantados[i] = -1;
+  proc->janela_leitura /= 2;
+  self->metricas->adiantadas_desperdicadas++;
+}
+
+// ajusta a janela de acordo com a falta em 'pagina' e reserva quadros livres
+//   para as páginas seguintes, que vão ser transferidas junto com ela
+static void so_reserva_leitura_adiantada(so_t *self, pcb *proc, int pagina)
+{
+  if (pagina == proc->proxima_falta_seq) {
+    proc->janela_leitura = proc->janela_leitura == 0 ? 1 : 2 * proc->janela_leitura;
+    if (proc->janela_leitura > MAX_LEITURA_ADIANTADA) {
+      proc->janela_leitura = MAX_LEITURA_ADIANTADA;
+    }
+  } else {
+    proc->janela_leitura = 0;
+  }
+  proc->pg_adiantada = pagina + 1;
+  int n = 0;
+  while (n < proc->janela_leitura && proc->pg_adiantada + n < proc->num_paginas) {
+    int quadro;
+    // a janela termina na primeira página que já está na memória
+    if (tabpag_traduz(proc->tabela_paginas, proc->pg_adiantada + n, &quadro) == ERR_OK) break;
+    if (so_quadro_compartilhado(proc, proc->pg_adiantada + n) >= 0) break;
+    quadro = pag_livre(self);
+    if (quadro < 0) break;
+    so_ocupa_quadro(self, quadro);
+    proc->quadros_adiantados[n] = quadro;
+    n++;
+  }
+  proc->n_adiantadas = n;
+  proc->proxima_falta_seq = proc->pg_adiantada + n;
+  self->metricas->paginas_adiantadas += n;
+}
+
+// copia para os quadros reservados as páginas da janela (chamada quando a
+//   transferência da página que causou a falta completa)
+static void so_completa_leitura_adiantada(so_t *self, pcb *proc)
+{
+  for (int i = 0; i < proc->n_adiantadas; i++) {
+    int quadro = proc->quadros_adiantados[i];
+    if (quadro < 0) continue;
+    int pagina = proc->pg_adiantada + i;
+    int end_disco = so_end_disco_pagina(proc, pagina);
+    if (mem_copia(self->mem, quadro * TAM_PAGINA, self->mem_sec, end_disco, TAM_PAGINA) != ERR_OK) {
+      console_printf("SO: erro copiando mem_sec addr %d para Q %d na leitura adiantada", end_disco, quadro);
+      self->erro_interno = true;
+      return;
+    }
+    donos_quadros_associa(self->donos_quadros, quadro, proc, pagina);
+    // ainda não foi acessada: é a primeira escolha para substituição
+    self->donos_quadros->idade[quadro] = 0;
+    if (es_le(self->es, D_RELOGIO_INSTRUCOES, &self->blocos_memoria[quadro].ciclos) != ERR_OK) {
+      console_printf("SO: erro lendo ciclos na leitura adiantada");
+      self->erro_interno = true;
+    }
+  }
+}
+
+// a página que causou a falta foi lida adiantada: só precisa ser mapeada
+static void so_usa_pagina_adiantada(so_t *self, pcb *proc, int i)
+{
+  int pagina = proc->pg_adiantada + i;
+  int quadro = proc->quadros_adiantados[i];
+  proc->quadros_adiantados[i] = -1;
+  self->metricas->adiantadas_usadas++;
+  if (so_pagina_compartilhada(proc, pagina)) {
+    // a página passa a ser compartilhada com os outros processos
+    so_compartilha_quadro(self, proc, pagina, quadro);
+  }
+  so_mapeia_pagina(self, proc, pagina, quadro);
+  // o processo continua executando, refazendo o acesso que causou a falta
+  proc->ctx_cpu.erro = ERR_OK;
+  proc->ctx_cpu.complemento = 0;
+  console_printf("SO: página %d do PID %d já tinha sido lida adiante (Q %d)", pagina, proc->pid, quadro);
+}
+
+// a página que causou a falta é compartilhada, e já está em um quadro mapeado
+//   por outros processos: só precisa ser mapeada
+static void so_usa_pagina_compartilhada(so_t *self, pcb *proc, int pagina)
+{
+  int quadro = so_quadro_compartilhado(proc, pagina);
+  self->metricas->paginas_compartilhadas++;
+  so_mapeia_pagina(self, proc, pagina, quadro);
+  // o processo continua executando, refazendo o acesso que causou a falta
+  proc->ctx_cpu.erro = ERR_OK;
+  proc->ctx_cpu.complemento = 0;
+  console_printf("SO: página %d do PID %d compartilhada com outro processo (Q %d)", pagina, proc->pid, quadro);
+}
+
+// CÓPIA NA ESCRITA
+// uma violação de proteção em uma página sem permissão de escrita mas
+//   compartilhada é a primeira escrita do processo na página: o processo
+//   ganha uma cópia só sua, com uma página própria na memória secundária,
+//   onde ela vai ser gravada quando for substituída. Se a página é da imagem
+//   e nenhum outro processo a tem mapeada, o próprio quadro passa a ser do
+//   processo, sem cópia do conteúdo; senão o quadro é duplicado.
+// se a página já é uma cópia que só o processo usa (os clones que a
+//   compartilhavam escreveram nela ou morreram), o quadro passa a ser dele,
+//   sem cópia nenhuma.
+
+// coloca o conteúdo do quadro 'quadro' em outro quadro, que é ocupado e
+//   retornado (ainda sem dono); o novo quadro é um livre ou o escolhido pelo
+//   algoritmo de substituição. Se a página que sai desse quadro precisar ser
+//   gravada, a gravação ocupa o disco, mas ninguém espera por ela, porque o
+//   conteúdo que vai ser usado já está na memória.
+// se o escolhido for o próprio 'quadro', ele já saiu de todas as tabelas e
+//   ainda tem o conteúdo, e não é copiado
+// retorna -1 se não conseguir outro quadro
+static int so_duplica_quadro(so_t *self, int quadro)
+{
+  int novo = pag_livre(self);
+  if (novo < 0) {
+    novo = escolher_alg_subst(self);
+    bool gravou;
+    if (novo < 0 || !so_esvazia_quadro(self, novo, &gravou)) return -1;
+    if (gravou) {
+      int agora = so_tempo_total(self);
+      int inicio = (self->disco_livre_ate > agora) ? self->disco_livre_ate : agora;
+      self->disco_livre_ate = inicio + self->tempo_transfer_pagina;
+    }
+  }
+  so_ocupa_quadro(self, novo);
+  if (novo != quadro) {
+    if (mem_copia(self->mem, novo * TAM_PAGINA, self->mem, quadro * TAM_PAGINA, TAM_PAGINA) != ERR_OK) {
+      console_printf("SO: erro copiando Q %d para Q %d na cópia na escrita", quadro, novo);
+      self->erro_interno = true;
+    }
+    self->metricas->copias_na_escrita++;
+  }
+  if (es_le(self->es, D_RELOGIO_INSTRUCOES, &self->blocos_memoria[novo].ciclos) != ERR_OK) {
+    console_printf("SO: erro lendo ciclos na cópia na escrita");
+    self->erro_interno = true;
+  }
+  return novo;
+}
+
+// retorna false se a violação não é uma escrita em página compartilhada (é
+//   um erro do processo), ou se não tem espaço na memória secundária ou
+//   principal para a cópia
+static bool so_trata_escrita_protegida(so_t *self, pcb *proc)
+{
+  int pagina = proc->ctx_cpu.complemento / TAM_PAGINA;
+  int quadro;
+  if (!so_pagina_compartilhada(proc, pagina)) return false;
+  if (tabpag_traduz(proc->tabela_paginas, pagina, &quadro) != ERR_OK) return false;
+  if (tabpag_permissao(proc->tabela_paginas, pagina) & TABPAG_ESCRITA) return false;
+  copia_t *copia = proc->copias[pagina];
+  bool so_do_processo;
+  if (copia != NULL) {
+    so_do_processo = (copia->refs == 1);
+  } else {
+    int n_mapeamentos = 0;
+    for (pcb *p = so_proximo_mapeamento(self, quadro, NULL); p != NULL;
+         p = so_proximo_mapeamento(self, quadro, p)) {
+      n_mapeamentos++;
+    }
+    so_do_processo = (n_mapeamentos == 1);
+  }
+  copia_t *nova = copia;
+  if (copia == NULL || copia->refs > 1) {
+    int pagina_disco = mapa_disco_aloca(self->mapa_disco, 1);
+    if (pagina_disco < 0) {
+      console_printf("SO: memória secundária sem espaço para a cópia da página %d do PID %d", pagina, proc->pid);
+      return false;
+    }
+    nova = copia_cria(pagina_disco);
+  }
+  int novo = quadro;
+  if (so_do_processo) {
+    so_descompartilha_quadro(self, quadro);
+  } else {
+    novo = so_duplica_quadro(self, quadro);
+    if (novo < 0) {
+      mapa_disco_libera(self->mapa_disco, nova->pagina_disco, 1);
+      free(nova);
+      return false;
+    }
+  }
+  if (nova != copia) {
+    if (copia != NULL) copia->refs--;
+    proc->copias[pagina] = nova;
+  }
+  nova->suja = false;
+  donos_quadros_associa(self->donos_quadros, novo, proc, pagina);
+  so_mapeia_pagina(self, proc, pagina, novo);
+  // a cópia ainda não está na memória secundária
+  tabpag_marca_bit_acesso(proc->tabela_paginas, pagina, true);
+  self->metricas->escritas_compartilhadas++;
+  proc->ctx_cpu.erro = ERR_OK;
+  proc->ctx_cpu.complemento = 0;
+  console_printf("SO: cópia na escrita da página %d do PID %d (Q %d -> Q %d)", pagina, proc->pid, quadro, novo);
+  return true;
+}
+
 static void so_trata_page_fault(so_t *self)
 {
   
-  pcb *proc_corrente = self->tabela_de_processos[self->processo_corrente];
+  pcb *proc_corrente = so_proc_corrente(self);
   proc_corrente->page_faults++;
   int end_causador = proc_corrente->ctx_cpu.complemento;
   int pagina_virtual = end_causador / TAM_PAGINA;
@@ -827,18 +1480,31 @@ static void so_trata_page_fault(so_t *self)
     return;
   }
 
-  console_printf("SO: tratando page fault para endereço %d (pagina %d)", end_causador, pagina_virtual);
-  bool existe_quadro_livre = false;
-  for (size_t i = 0; i < self->num_paginas_fisicas; i++) {
-    if (!self->blocos_memoria[i].ocupado) { existe_quadro_livre = true; break; }
+  // a página compartilhada pode já estar na memória, trazida por outro processo
+  if (so_quadro_compartilhado(proc_corrente, pagina_virtual) >= 0) {
+    so_usa_pagina_compartilhada(self, proc_corrente, pagina_virtual);
+    return;
   }
+
+  int i_adiantada = so_indice_adiantada(proc_corrente, pagina_virtual);
+  if (i_adiantada >= 0) {
+    so_usa_pagina_adiantada(self, proc_corrente, i_adiantada);
+    return;
+  }
+  // a página não está na janela: o que sobrou dela não vai ser usado
+  so_descarta_leitura_adiantada(self, proc_corrente);
+
+  console_printf("SO: tratando page fault para endereço %d (pagina %d)", end_causador, pagina_virtual);
   int pg_livre_idx = pag_livre(self);
-  if (existe_quadro_livre) {
+  if (pg_livre_idx >= 0) {
     schedule_page_transfer(self, proc_corrente, end_causador, pg_livre_idx);
   } else {
     int pg_a_substituir = escolher_alg_subst(self);
     schedule_page_transfer(self, proc_corrente, end_causador, pg_a_substituir);
   }
+  if (proc_corrente->swap_pendente) {
+    so_reserva_leitura_adiantada(self, proc_corrente, pagina_virtual);
+  }
 }
 
 
@@ -922,13 +1588,6 @@ static void so_trata_reset(so_t *self)
 
 
   /// processos
-  // inicializa a tabela de processos
-  // tabela_de_processos já é um array fixo, não precisa de malloc
-  for (int i = 0; i < MAX_PROCESSES; i++)
-  {
-    self->tabela_de_processos[i] = NULL;
-  }
-
   // coloca o programa init na memória
   // coloca o endereço do programa init np primeiro processo
   console_printf("SO: criando processo inicial (init)");
@@ -944,9 +1603,9 @@ static void so_trata_reset(so_t *self)
   }
   
   // marcar o terminal usado
-  self->terminais_usados[0] = processo_inicial->pid;
-  self->tabela_de_processos[0] = processo_inicial;
-  self->processo_corrente = 0; // índice do processo inicial na tabela
+  so_usa_terminal(self, processo_inicial);
+  // a tabela está vazia, o init fica na posição 0
+  self->processo_corrente = tabproc_insere(self->tabela_de_processos, processo_inicial);
 
   // altera o PC para o endereço de carga
   // self->regPC = ender; // deveria ser no processo
@@ -963,35 +1622,28 @@ static void so_trata_reset(so_t *self)
   // processo_inicial->estado = P_PRONTO;
   //inicializa métricas 
   int tempo_atual = so_tempo_total(self); // Tempo é 0
-  inicializa_metricas_pcb(processo_inicial, tempo_atual);
+  inicializa_metricas_pcb(self, processo_inicial, tempo_atual);
   so_muda_estado(self, processo_inicial, P_PRONTO); //substitui processo_inicial->estado = P_PRONTO
   // coloca init na fila de prontos
-  enfileira(self->fila_prontos, processo_inicial->pid);
+  so_torna_pronto(self, processo_inicial);
   self->metricas->num_proc_criados++;
 
 }
-//acorda qualquer processo que estava bloqueado esperando 'pid_que_morreu'
-static void so_acorda_processos_esperando(so_t *self, int pid_que_morreu)
+//acorda os processos que estavam bloqueados esperando 'proc_que_morreu'
+//  (estão na fila dele, ver so_chamada_espera_proc)
+static void so_acorda_processos_esperando(so_t *self, pcb *proc_que_morreu)
 {
-  if (pid_que_morreu <= 0)
-    return; // PID inválido
-
-  for (int i = 0; i < MAX_PROCESSES; i++)
+  pcb *proc;
+  while ((proc = fila_primeiro(&proc_que_morreu->esperando_fim)) != NULL)
   {
-    pcb *proc = self->tabela_de_processos[i];
-
-    //se o processo [i] estava bloqueado esperando o PID que acabou de morrer
-    if (proc != NULL && proc->estado == P_BLOQUEADO && proc->pid_esperando == pid_que_morreu)
-    {
-      console_printf("SO: processo %d (que morreu) estava sendo esperado por %d. Acordando.",
-      pid_que_morreu, proc->pid);
-      //proc->estado = P_PRONTO;
-      so_muda_estado(self, proc, P_PRONTO); // usa a função que contabiliza métricas
-      proc->pid_esperando = -1; //nao está mais esperando
-      proc->ctx_cpu.regA = 0;   //retorna sucesso para a chamada SO_ESPERA_PROC
-      // colocar na fila de prontos
-      enfileira(self->fila_prontos, proc->pid);
-    }
+    console_printf("SO: processo %d (que morreu) estava sendo esperado por %d. Acordando.",
+    proc_que_morreu->pid, proc->pid);
+    //proc->estado = P_PRONTO;
+    so_muda_estado(self, proc, P_PRONTO); // usa a função que contabiliza métricas
+    proc->pid_esperando = -1; //nao está mais esperando
+    proc->ctx_cpu.regA = 0;   //retorna sucesso para a chamada SO_ESPERA_PROC
+    // colocar na fila de prontos (sai da fila do processo que morreu)
+    so_torna_pronto(self, proc);
   }
 }
 
@@ -1001,7 +1653,7 @@ static void so_trata_irq_err_cpu(so_t *self)
 {
   if (self->processo_corrente != NO_PROCESS)
   {
-    pcb *proc = self->tabela_de_processos[self->processo_corrente];
+    pcb *proc = so_proc_corrente(self);
     err_t erro = proc->ctx_cpu.erro;
     int complemento = proc->ctx_cpu.complemento;
     console_printf("SO: Erro de CPU detectado: Código %d. Complemento %d. PC %d.",
@@ -1012,6 +1664,10 @@ static void so_trata_irq_err_cpu(so_t *self)
       so_trata_page_fault(self);
       return;
     }
+    else if (erro == ERR_PAG_PROTEGIDA && so_trata_escrita_protegida(self, proc))
+    {
+      return;
+    }
     else if (erro == ERR_INSTR_INV)
     {
       /* DEBUG: imprimir dump físico aonde o PC pontua para ver o que CPU "vê" */
@@ -1044,21 +1700,27 @@ static void so_trata_irq_err_cpu(so_t *self)
       
       /* Para evitar flood de mensagens durante a depuração, encerraremos o processo.
          Remova ou ajuste isso quando confirmar/fixar a causa. */
-      so_acorda_processos_esperando(self, proc->pid);
+      so_acorda_processos_esperando(self, proc);
       proc->usando = 0;
       so_muda_estado(self, proc, P_TERMINOU);
+      esc_terminou(self->escalonador, proc);
+      enfileira(self->fila_terminados, proc);
+      so_libera_memoria_do_processo(self, proc);
       self->processo_corrente = NO_PROCESS;
-      libera_terminal(self, proc->pid);
+      libera_terminal(self, proc);
       return;
     }
     else
     {
       console_printf("SO: erro na CPU do processo %d: %s", proc->pid, err_nome(erro));
-      so_acorda_processos_esperando(self, proc->pid);
+      so_acorda_processos_esperando(self, proc);
       proc->usando = 0;
       so_muda_estado(self, proc, P_TERMINOU);
+      esc_terminou(self->escalonador, proc);
+      enfileira(self->fila_terminados, proc);
+      so_libera_memoria_do_processo(self, proc);
       self->processo_corrente = NO_PROCESS;
-      libera_terminal(self, proc->pid);
+      libera_terminal(self, proc);
       console_printf("SO: IRQ TRATADA -- erro na CPU: %s", err_nome(erro));
       return;
     }
@@ -1074,7 +1736,13 @@ static void so_trata_irq_relogio(so_t *self)
   e2 = es_escreve(self->es, D_RELOGIO_TIMER, INTERVALO_INTERRUPCAO);
 
   //atualizar o acesso das paginas para LRU
-  so_envelhece_quadros(self);
+  // (os outros algoritmos não usam o envelhecimento, e o CLOCK precisa que os
+  //   bits de acesso não sejam zerados aqui)
+  if (ALG_SUBSTITUICAO == ALG_LRU) {
+    so_envelhece_quadros(self);
+  }
+  // aproveita o disco ocioso para gravar páginas alteradas
+  so_limpa_paginas(self);
 
   if (e1 != ERR_OK || e2 != ERR_OK) {
     console_printf("SO: problema da reinicialização do timer");
@@ -1083,12 +1751,9 @@ static void so_trata_irq_relogio(so_t *self)
   // t2: deveria tratar a interrupção
   //   por exemplo, decrementa o quantum do processo corrente, quando se tem
   //   um escalonador com quantum
-  pcb *proc_corrente = self->tabela_de_processos[self->processo_corrente];
-  if (proc_corrente == NULL || self->processo_corrente == NO_PROCESS) {
-    return;
-  }
-  proc_corrente->quantum--;
-  if (proc_corrente->quantum <= 0 && proc_corrente->estado!= P_BLOQUEADO){
+  // o quantum é da política; ela diz se o processo corrente deve sair
+  pcb *proc_corrente = so_proc_corrente(self);
+  if (esc_relogio(self->escalonador, proc_corrente)) {
     console_printf("SO: quantum do processo %d expirou, forçando troca de contexto.", proc_corrente->pid);
     // --- Métricas 5 e 7 ---
     proc_corrente->num_preempcoes_proc++;
@@ -1096,9 +1761,8 @@ static void so_trata_irq_relogio(so_t *self)
     // --- Fim Métricas ---
     //proc_corrente->estado = P_PRONTO;
     so_muda_estado(self, proc_corrente, P_PRONTO); // usa a função que contabiliza métricas
-    proc_corrente->quantum = QUANTUM; // reseta o quantum
     self->processo_corrente = NO_PROCESS; // força o escalonador a escolher outro processo
-    enfileira(self->fila_prontos, proc_corrente->pid);
+    so_torna_pronto(self, proc_corrente);
   }
 }
 
@@ -1120,13 +1784,15 @@ static void so_chamada_escr(so_t *self);
 static void so_chamada_cria_proc(so_t *self);
 static void so_chamada_mata_proc(so_t *self);
 static void so_chamada_espera_proc(so_t *self);
+static void so_chamada_clona_proc(so_t *self);
+static void so_chamada_peso_proc(so_t *self);
 
 
 static void so_trata_irq_chamada_sistema(so_t *self)
 {
   // a identificação da chamada está no registrador A
   // t2: com processos, o reg A deve estar no descritor do processo corrente
-  pcb *proc = self->tabela_de_processos[self->processo_corrente];
+  pcb *proc = so_proc_corrente(self);
   int id_chamada = proc->ctx_cpu.regA;
   console_printf("SO: chamada de sistema %d", id_chamada);
   switch (id_chamada) {
@@ -1145,6 +1811,12 @@ static void so_trata_irq_chamada_sistema(so_t *self)
     case SO_ESPERA_PROC:
       so_chamada_espera_proc(self);
       break;
+    case SO_CLONA_PROC:
+      so_chamada_clona_proc(self);
+      break;
+    case SO_PESO_PROC:
+      so_chamada_peso_proc(self);
+      break;
     default:
       console_printf("SO: chamada de sistema desconhecida (%d)", id_chamada);
       // t2: deveria matar o processo
@@ -1166,7 +1838,7 @@ static void so_chamada_le(so_t *self)
   //     o caso
   // implementação lendo direto do terminal A
   //   t2: deveria usar dispositivo de entrada corrente do processo
-  pcb *proc = self->tabela_de_processos[self->processo_corrente];
+  pcb *proc = so_proc_corrente(self);
   dispositivo_id_t entrada = proc->entrada;  // Ex: D_TERM_B_TECLADO
   dispositivo_id_t entrada_ok = entrada + 1; // Ex: D_TERM_B_TECLADO_OK
 
@@ -1204,7 +1876,9 @@ static void so_chamada_le(so_t *self)
     console_printf("SO: processo %d bloqueado esperando E/S (leitura)", proc->pid);
     //proc->estado = P_BLOQUEADO;
     so_muda_estado(self, proc, P_BLOQUEADO); // usa a função que contabiliza métricas
+    esc_bloqueou(self->escalonador, proc);
     proc->dispositivo_bloqueado = entrada; // salva qual dispositivo está esperando
+    enfileira(self->fila_bloqueados_es, proc);
     self->processo_corrente = NO_PROCESS;  // força o escalonador a rodar
     //desenfileira(self->fila_prontos, proc->pid);    // retira o processo corrente da fila de prontos
   }
@@ -1218,7 +1892,7 @@ static void so_chamada_escr(so_t *self)
   //   t2: deveria bloquear o processo se dispositivo ocupado
   // implementação escrevendo direto do terminal A
   //   t2: deveria usar o dispositivo de saída corrente do processo
-  pcb *proc = self->tabela_de_processos[self->processo_corrente];
+  pcb *proc = so_proc_corrente(self);
   dispositivo_id_t saida = proc->saida;  // Ex: D_TERM_B_TELA
   dispositivo_id_t saida_ok = saida + 1; // Ex: D_TERM_B_TELA_OK
 
@@ -1260,7 +1934,9 @@ static void so_chamada_escr(so_t *self)
     console_printf("SO: processo %d bloqueado esperando E/S (escrita)", proc->pid);
     //proc->estado = P_BLOQUEADO;
     so_muda_estado(self, proc, P_BLOQUEADO); // usa a função que contabiliza métricas
+    esc_bloqueou(self->escalonador, proc);
     proc->dispositivo_bloqueado = saida;  // Salva qual dispositivo está esperando
+    enfileira(self->fila_bloqueados_es, proc);
     self->processo_corrente = NO_PROCESS; // Força o escalonador a rodar
     //desenfileira(self->fila_prontos, proc->pid);    // retira o processo corrente da fila de prontos
   }
@@ -1298,16 +1974,32 @@ static dispositivo_id_t id_terminal_livre(int idx)
   }
 }
 
-static void libera_terminal(so_t *self, int pid)
+// retorna o índice do terminal de um dispositivo (entrada ou saída de
+//   processo), ou -1
+static int so_indice_terminal(dispositivo_id_t dispositivo)
 {
-  for (int i = 0; i < TERMINAIS; i++)
-  {
-    if (self->terminais_usados[i] == pid)
-    {
-      self->terminais_usados[i] = 0;
-      return;
-    }
-  }
+  int i = (dispositivo - D_TERM_A) / (D_TERM_B - D_TERM_A);
+  if (dispositivo < D_TERM_A || i >= TERMINAIS) return -1;
+  return i;
+}
+
+// conta o processo entre os que usam o seu terminal
+static void so_usa_terminal(so_t *self, pcb *proc)
+{
+  int i = so_indice_terminal(proc->entrada);
+  if (i < 0 || proc->conta_terminal) return;
+  self->terminais_usados[i]++;
+  proc->conta_terminal = true;
+}
+
+// o processo não usa mais o terminal; ele fica livre quando o último que
+//   usa sai (pode ser chamada mais de uma vez para o mesmo processo)
+static void libera_terminal(so_t *self, pcb *proc)
+{
+  int i = so_indice_terminal(proc->entrada);
+  if (i < 0 || !proc->conta_terminal) return;
+  self->terminais_usados[i]--;
+  proc->conta_terminal = false;
 }
 
 // implementação da chamada se sistema SO_CRIA_PROC
@@ -1323,31 +2015,22 @@ static void so_chamada_cria_proc(so_t *self)
 
   // aponta para o processo corrente na tabela de processos
   // pega o processo corrente para ler o X e pegar o nome do arquivo
-  pcb *processo_criador = self->tabela_de_processos[self->processo_corrente];
+  pcb *processo_criador = so_proc_corrente(self);
   //int nome_arquivo = processo_corrente->ctx_cpu.regX;
 
   // em X está o endereço onde está o nome do arquivo
   // int ender_proc;
 
-  // achar uma posição vazia na tabela de processos, para colocar o processo novo
-  int possivel_indice = -1;
-  for (int i = 0; i < MAX_PROCESSES; i++)
-  {
-    if (self->tabela_de_processos[i] == NULL)
-    {
-      possivel_indice = i;
-      break;
-    }
-  }
-  if (possivel_indice == -1)
+  // a tabela cresce, mas só até MAX_PROCESSES
+  if (tabproc_cheia(self->tabela_de_processos))
   {
     // não tem mais espaço na tabela de processos
     console_printf("sem espaço na tabela de processos");
-    self->regA = -1; // erro
+    processo_criador->ctx_cpu.regA = -1; // erro
     return;
   }
   // t2: deveria ler o X do descritor do processo criador
-  int ender_proc = self->tabela_de_processos[self->processo_corrente]->ctx_cpu.regX;
+  int ender_proc = so_proc_corrente(self)->ctx_cpu.regX;
   char nome[100];
   if (so_copia_str_do_processo(self, 100, nome, ender_proc, processo_criador))
   {
@@ -1372,7 +2055,10 @@ static void so_chamada_cria_proc(so_t *self)
       //self->regA = -1; // erro
       /* liberar/descartar o PCB criado e sinalizar erro ao processo pai */
     // liberar recursos alocados pelo PCB (liberar tabela de páginas se criada)
-    if (novo_processo->tabela_paginas) tabpag_destroi(novo_processo->tabela_paginas);
+    if (novo_processo->tabela_paginas) {
+      mmu_invalida_tabpag(self->mmu, novo_processo->tabela_paginas);
+      tabpag_destroi(novo_processo->tabela_paginas);
+    }
     free(novo_processo);
     processo_criador->ctx_cpu.regA = -1; // informar erro no regA do criador
       return;
@@ -1381,13 +2067,13 @@ static void so_chamada_cria_proc(so_t *self)
     }
    
    // console_printf("SO: Primeira página do processo %d carregada e mapeada para QF %d.", novo_processo->pid, quadro_livre_principal);
-    // marca o terminal como usado com o pid do processo que está usando
-    self->terminais_usados[terminal_id] = novo_processo->pid;
-    self->tabela_de_processos[possivel_indice] = novo_processo; // colocar o processo na tabela
+    // marca o terminal como usado pelo processo
+    so_usa_terminal(self, novo_processo);
+    tabproc_insere(self->tabela_de_processos, novo_processo); // colocar o processo na tabela
     //novo_processo->estado = P_PRONTO;
     //inicializa Métricas (Novo Processo)
     int tempo_atual = so_tempo_total(self);
-    inicializa_metricas_pcb(novo_processo, tempo_atual);
+    inicializa_metricas_pcb(self, novo_processo, tempo_atual);
     so_muda_estado(self, novo_processo, P_PRONTO); // substitui novo_processo->estado = P_PRONTO
     // t2: deveria escrever no PC do descritor do processo criado (antes: //self->regPC = ender_carga;)
     novo_processo->ctx_cpu.pc = ender_carga;
@@ -1395,7 +2081,7 @@ static void so_chamada_cria_proc(so_t *self)
     // escrever o PID do processo criado no reg A do processo que pediu a criação
     processo_criador->ctx_cpu.regA = novo_processo->pid;
     // inserir na fila de processos prontos
-    enfileira(self->fila_prontos, novo_processo->pid);
+    so_torna_pronto(self, novo_processo);
 
     debug_imprime_tabela_processos(self);
 
@@ -1403,13 +2089,87 @@ static void so_chamada_cria_proc(so_t *self)
 
     return;
   }
+  // não conseguiu ler o nome do programa
+  processo_criador->ctx_cpu.regA = -1; // erro
+}
+
+// implementação da chamada de sistema SO_CLONA_PROC
+// cria um clone do processo corrente sem copiar nada da memória: o clone usa
+//   a mesma imagem e as mesmas cópias de páginas, e as páginas do processo que
+//   estão na memória passam a estar em quadros compartilhados, mapeados nos
+//   dois processos sem permissão de escrita. A primeira escrita de qualquer um
+//   dos dois em uma página faz a cópia dela (ver so_trata_escrita_protegida).
+// o custo é o de percorrer a tabela de páginas do processo
+static void so_chamada_clona_proc(so_t *self)
+{
+  pcb *pai = so_proc_corrente(self);
+
+  if (tabproc_cheia(self->tabela_de_processos) || pai->imagem == NULL)
+  {
+    console_printf("SO: não foi possível clonar o processo %d", pai->pid);
+    pai->ctx_cpu.regA = -1;
+    return;
+  }
+
+  // o clone continua do mesmo ponto, com os mesmos dispositivos
+  pcb *filho = criar_processo(pai->entrada, pai->saida);
+  filho->ctx_cpu = pai->ctx_cpu;
+  filho->ctx_cpu.regA = 0;
+  filho->peso = pai->peso;
+  so_usa_terminal(self, filho);
+  so_usa_imagem(self, filho, pai->imagem);
+
+  for (int pg = 0; pg < pai->num_paginas; pg++) {
+    copia_t *copia = pai->copias[pg];
+    if (copia != NULL) {
+      copia->refs++;
+      filho->copias[pg] = copia;
+    }
+    int quadro;
+    if (tabpag_traduz(pai->tabela_paginas, pg, &quadro) != ERR_OK) continue;
+    if (self->donos_quadros->dono[quadro] == pai) {
+      // a cópia era só do pai; o conteúdo do quadro pode ainda não estar
+      //   na memória secundária
+      copia->suja = tabpag_bit_alteracao(pai->tabela_paginas, pg);
+      so_compartilha_quadro(self, pai, pg, quadro);
+      so_mapeia_pagina(self, pai, pg, quadro);
+    }
+    so_mapeia_pagina(self, filho, pg, quadro);
+  }
+
+  tabproc_insere(self->tabela_de_processos, filho);
+  inicializa_metricas_pcb(self, filho, so_tempo_total(self));
+  so_muda_estado(self, filho, P_PRONTO);
+  so_torna_pronto(self, filho);
+  pai->ctx_cpu.regA = filho->pid;
+  self->metricas->num_proc_criados++;
+  self->metricas->processos_clonados++;
+  console_printf("SO: PID %d clonado, clone com PID %d", pai->pid, filho->pid);
+}
+
+// implementação da chamada de sistema SO_PESO_PROC
+// muda o peso do processo corrente para X; o peso anterior vai no reg A
+static void so_chamada_peso_proc(so_t *self)
+{
+  pcb *proc = so_proc_corrente(self);
+  int peso = proc->ctx_cpu.regX;
+
+  if (peso < 1 || peso > PESO_MAX) {
+    console_printf("SO: peso %d inválido para o processo %d", peso, proc->pid);
+    proc->ctx_cpu.regA = -1;
+    return;
+  }
+
+  proc->ctx_cpu.regA = proc->peso;
+  so_muda_peso(self, proc, peso);
+  console_printf("SO: processo %d com peso %d", proc->pid, peso);
 }
 
 // implementação da chamada se sistema SO_MATA_PROC
 // mata o processo com pid X (ou o processo corrente se X é 0)
 static void so_chamada_mata_proc(so_t *self)
 {
-  pcb *proc_corrente = self->tabela_de_processos[self->processo_corrente];
+  pcb *proc_corrente = so_proc_corrente(self);
   int pid_a_matar = proc_corrente->ctx_cpu.regX;
   pcb *proc_alvo;
 
@@ -1432,29 +2192,19 @@ static void so_chamada_mata_proc(so_t *self)
     return;
   }
   console_printf("SO-DBG: so_chamada_mata_proc: matando PID %d (idx %d). Chamando so_acorda_processos_esperando...", proc_alvo->pid, /* índice se tiver */ self->processo_corrente);
-  so_acorda_processos_esperando(self, proc_alvo->pid);
+  so_acorda_processos_esperando(self, proc_alvo);
   //console_printf("SO-DBG: pid_morto=%d; acordando quem aguardava...", proc_alvo->pid);
   //proc_alvo->estado = P_TERMINOU;
   so_muda_estado(self, proc_alvo, P_TERMINOU); // usa a função que contabiliza métricas
+  esc_terminou(self->escalonador, proc_alvo);
 
   //zerar os recursos de memoria do proc morto 
-  for(int i=BLOCOS_RESERVADOS; i< self->num_paginas_fisicas; i++){
-    if(self->blocos_memoria[i].pid == proc_alvo->pid){
-      self->blocos_memoria[i].pid = 0;
-      self->blocos_memoria[i].ocupado = false;
-      self->blocos_memoria[i].acesso = 0;
-    }
-  }
+  so_libera_memoria_do_processo(self, proc_alvo);
   
   proc_alvo->usando = 0;
-  libera_terminal(self, proc_alvo->pid);
-  //desenfileira(self->fila_prontos, proc_alvo->pid);
-  if (proc_alvo->estado == P_PRONTO) {
-    desenfileira(self->fila_prontos, proc_alvo->pid);
-  }
-  //destuir tabela de pg do processo 
-  tabpag_t* tabela_pg = proc_alvo->tabela_paginas;
-  tabpag_destroi(tabela_pg);
+  libera_terminal(self, proc_alvo);
+  // sai da fila em que estiver (prontos ou bloqueados) e espera a limpeza
+  enfileira(self->fila_terminados, proc_alvo);
 
   // se matou a si mesmo, não há processo corrente
   if (matando_a_si_mesmo){
@@ -1466,11 +2216,37 @@ static void so_chamada_mata_proc(so_t *self)
   //se ele se matou NADA é escrito no regA.
 }
 
+// libera a memória de um processo que terminou: os quadros da sua lista (não
+//   a memória toda), o reservado para uma transferência que não vai mais
+//   completar, a tabela de páginas e a imagem (ver so_solta_imagem)
+static void so_libera_memoria_do_processo(so_t *self, pcb *proc)
+{
+  so_descarta_leitura_adiantada(self, proc);
+  if (proc->swap_pendente && proc->pending_swap_quadro >= 0) {
+    so_libera_quadro(self, proc->pending_swap_quadro);
+    proc->swap_pendente = 0;
+    proc->pending_swap_quadro = -1;
+  }
+  while (proc->primeiro_quadro >= 0) {
+    int quadro = proc->primeiro_quadro;
+    donos_quadros_desassocia(self->donos_quadros, quadro);
+    so_libera_quadro(self, quadro);
+  }
+  // sai da imagem antes de destruir a tabela: os quadros da imagem procuram
+  //   os seus mapeamentos nas tabelas dos usuários
+  so_solta_imagem(self, proc);
+  if (proc->tabela_paginas != NULL) {
+    mmu_invalida_tabpag(self->mmu, proc->tabela_paginas);
+    tabpag_destroi(proc->tabela_paginas);
+    proc->tabela_paginas = NULL;
+  }
+}
+
 // implementação da chamada se sistema SO_ESPERA_PROC
 // espera o fim do processo com pid X
 static void so_chamada_espera_proc(so_t *self)
 {
-  pcb *proc_corrente = self->tabela_de_processos[self->processo_corrente];
+  pcb *proc_corrente = so_proc_corrente(self);
   int pid_esperado = proc_corrente->ctx_cpu.regX;
 
   // checar se o pid é inválido (0 ou ele mesmo)
@@ -1497,7 +2273,9 @@ static void so_chamada_espera_proc(so_t *self)
     console_printf("SO: processo %d esperando o processo %d", proc_corrente->pid, pid_esperado);
     //proc_corrente->estado = P_BLOQUEADO;
     so_muda_estado(self, proc_corrente, P_BLOQUEADO); // usa a função que contabiliza métricas
+    esc_bloqueou(self->escalonador, proc_corrente);
     proc_corrente->pid_esperando = pid_esperado;
+    enfileira(&proc_esperado->esperando_fim, proc_corrente);
     self->processo_corrente = NO_PROCESS;
     //desenfileira(self->fila_prontos, proc_corrente->pid);
   }
@@ -1517,18 +2295,44 @@ static void so_chamada_espera_proc(so_t *self)
 static int so_carrega_programa_na_memoria_fisica(so_t *self, programa_t *programa);
 static int so_carrega_programa_na_memoria_virtual(so_t *self,
                                                   programa_t *programa,
-                                                  pcb* processo);
+                                                  pcb* processo,
+                                                  char *nome_do_executavel,
+                                                  struct stat *st);
 
 // carrega o programa na memória
 // se processo for NENHUM_PROCESSO, carrega o programa na memória física
-//   senão, carrega na memória virtual do processo
+//   senão, carrega na memória virtual do processo; se o programa já estiver
+//   carregado para outro processo, a imagem dele é compartilhada, e o
+//   arquivo nem é lido; senão o programa vem do cache de programas, que só
+//   lê o arquivo se ele mudou desde a última leitura
+// a imagem só é compartilhada se o arquivo não mudou desde que ela foi
+//   carregada; as informações do arquivo são vistas antes da leitura, então
+//   se ele mudar durante a carga a imagem fica com a data antiga e é
+//   carregada de novo na próxima vez (nunca fica com a data nova e o
+//   conteúdo antigo)
 // retorna o endereço de carga ou -1
 static int so_carrega_programa(so_t *self, pcb* processo,
                                char *nome_do_executavel)
 {
   console_printf("SO: carga de '%s'", nome_do_executavel);
 
-  programa_t *programa = prog_cria(nome_do_executavel);
+  struct stat st;
+  if (processo != NENHUM_PROCESSO) {
+    if (stat(nome_do_executavel, &st) != 0) {
+      console_printf("Erro na leitura do programa '%s'\n", nome_do_executavel);
+      return -1;
+    }
+    imagem_t *img = imagens_busca(self->imagens, nome_do_executavel, &st);
+    if (img != NULL) {
+      so_usa_imagem(self, processo, img);
+      self->metricas->imagens_reaproveitadas++;
+      console_printf("SO: '%s' já está na memória secundária, %d processos usando",
+                     nome_do_executavel, img->refs);
+      return 0;
+    }
+  }
+
+  programa_t *programa = programas_pega(self->programas, nome_do_executavel);
   if (programa == NULL) {
     console_printf("Erro na leitura do programa '%s'\n", nome_do_executavel);
     return -1;
@@ -1541,11 +2345,12 @@ static int so_carrega_programa(so_t *self, pcb* processo,
     // so_carrega_programa_na_memoria_virtual agora se responsabiliza por
     // definir processo->end_disco (endereço físico em mem_fisica) e retornar
     // o endereço virtual inicial (tipicamente 0)
-    end_carga = so_carrega_programa_na_memoria_virtual(self, programa, processo);
-    end_carga = 0; // end_carga virtual sempre começa em 0
+    end_carga = so_carrega_programa_na_memoria_virtual(self, programa, processo,
+                                                       nome_do_executavel, &st);
+    if (end_carga >= 0) end_carga = 0; // end_carga virtual sempre começa em 0
   }
   
-  prog_destroi(programa);
+  // o programa fica no cache
   return end_carga;
 }
 
@@ -1554,8 +2359,8 @@ static void so_inicializa_bloco_fisico(so_t *self, int end_ini, int end_fim, int
   for(int end = end_ini; end < end_fim; end += TAM_PAGINA){
     int idx = end / TAM_PAGINA;
     if (idx >= 0 && idx < self->num_paginas_fisicas) {
-      self->blocos_memoria[idx].pid = pid;
-      self->blocos_memoria[idx].ocupado = true;
+      self->donos_quadros->pid[idx] = pid;
+      so_ocupa_quadro(self, idx);
     } else {
       console_printf("SO: aviso so_inicializa_bloco_fisico índice fora de faixa: %d", idx);
     }
@@ -1568,11 +2373,9 @@ static int so_carrega_programa_na_memoria_fisica(so_t *self, programa_t *program
   int end_ini = prog_end_carga(programa);
   int end_fim = end_ini + prog_tamanho(programa);
 
-  for (int end = end_ini; end < end_fim; end++) {
-    if (mem_escreve(self->mem, end, prog_dado(programa, end)) != ERR_OK) {
-      console_printf("Erro na carga da memória, endereco %d\n", end);
-      return -1;
-    }
+  if (mem_escreve_bloco(self->mem, end_ini, prog_tamanho(programa), prog_dados(programa)) != ERR_OK) {
+    console_printf("Erro na carga da memória, enderecos %d-%d\n", end_ini, end_fim - 1);
+    return -1;
   }
   so_inicializa_bloco_fisico(self, end_ini, end_fim, 0); // pid 0 para SO
   //0 pq é o trata_int.maq que carrega os processos
@@ -1584,45 +2387,48 @@ static int so_carrega_programa_na_memoria_fisica(so_t *self, programa_t *program
 
 static int so_carrega_programa_na_memoria_virtual(so_t *self,
                                                   programa_t *programa,
-                                                  pcb* processo)
+                                                  pcb* processo,
+                                                  char *nome_do_executavel,
+                                                  struct stat *st)
 {
-  // t3: isto tá furado...
-  // está simplesmente lendo para o próximo quadro que nunca foi ocupado,
-  //   nem testa se tem memória disponível
   // com memória virtual, a forma mais simples de implementar a carga de um
   //   programa é carregá-lo para a memória secundária, e mapear todas as páginas
   //   da tabela de páginas do processo como inválidas. Assim, as páginas serão
   //   colocadas na memória principal por demanda. Para simplificar ainda mais, a
-  //   memória secundária pode ser alocada da forma como a principal está sendo
-  //   alocada aqui (sem reuso)
+  //   memória secundária é alocada em páginas, em um trecho contíguo por
+  //   programa (ver mapa_disco_t), que vira uma imagem compartilhada pelos
+  //   processos que executam o programa (ver imagem.h)
   // carrega o programa na memória secundaria
   
-  int end_fis_ini = self->bloco_livre;//onde o conteúdo está guardado no disco
-  int end_fis = end_fis_ini;
   int end_virt_ini = 0; //onde o conteúdo deve existir no espaço virtual do processo
   //o dispatcher e o próprio processo precisam do end_virt_ini para inicializar o PC do processo.
   int prog_tamanho_bytes = prog_tamanho(programa);
   int end_virt_fim = end_virt_ini + prog_tamanho_bytes - 1;
 
-  // escreve o programa em mem_sec (disco simulado) a partir de end_fis_ini
-  for (int end_virt = end_virt_ini; end_virt <= end_virt_fim; end_virt++) {
-    if (mem_escreve(self->mem_sec, end_fis, prog_dado(programa, end_virt)) != ERR_OK) {
-      console_printf("Erro na carga da memória secundaria, end virt %d fís %d\n", end_virt,
-                     end_fis);
-      return -1;
-    }
-    end_fis++;
+  // calcula corretamente o número de páginas ocupadas no disco
+  int num_paginas = (end_virt_fim - end_virt_ini) / TAM_PAGINA + 1;
+  int pagina_disco = mapa_disco_aloca(self->mapa_disco, num_paginas);
+  if (pagina_disco < 0) {
+    console_printf("SO: memória secundária sem espaço para %d páginas", num_paginas);
+    return -1;
   }
+  int end_fis_ini = pagina_disco * TAM_PAGINA;//onde o conteúdo está guardado no disco
+  int end_fis = end_fis_ini;
 
-  // atualiza o bloco_livre para apontar para a próxima posição livre em mem_fisica
-  self->bloco_livre = end_fis;
-
-
-  // salva para o processo o endereço físico inicial em mem_fisica (onde o programa foi colocado)
-  processo->end_disco = end_fis_ini;
+  // escreve o programa em mem_sec (disco simulado) a partir de end_fis_ini
+  if (mem_escreve_bloco(self->mem_sec, end_fis_ini, prog_tamanho_bytes, prog_dados(programa)) != ERR_OK) {
+    console_printf("Erro na carga da memória secundaria, end virt %d-%d fís %d\n", end_virt_ini,
+                   end_virt_fim, end_fis_ini);
+    mapa_disco_libera(self->mapa_disco, pagina_disco, num_paginas);
+    return -1;
+  }
+  end_fis += prog_tamanho_bytes;
 
-  // calcula corretamente o número de páginas ocupadas no disco
-  int num_paginas = (end_virt_fim - end_virt_ini) / TAM_PAGINA + 1;
+  // o processo usa a imagem que acabou de ser carregada
+  imagem_t *img = imagens_insere(self->imagens, nome_do_executavel, st,
+                                 pagina_disco, num_paginas);
+  so_usa_imagem(self, processo, img);
+  self->metricas->imagens_carregadas++;
   console_printf("SO: carga na memória secundaria V%d-%d F%d-%d npag=%d",
                  end_virt_ini, end_virt_fim, end_fis_ini, end_fis - 1, num_paginas);
   //return end_virt_ini;
@@ -1654,8 +2460,8 @@ static bool so_copia_str_do_processo(so_t *self, int tam, char str[tam],
     if (mmu_le(self->mmu, end_virt + indice_str, &caractere, usuario) != ERR_OK) {
       //return false;
       // se não está na memória principal, busca na memória secundária (disco)
-      pcb *proc = self->tabela_de_processos[self->processo_corrente];
-      mem_le(self->mem_sec, proc->end_disco + end_virt + indice_str, &caractere);
+      int end = end_virt + indice_str;
+      mem_le(self->mem_sec, so_end_disco_pagina(processo, end / TAM_PAGINA) + end % TAM_PAGINA, &caractere);
     }
     if (caractere < 0 || caractere > 255) {
       return false;
@@ -1668,15 +2474,15 @@ static bool so_copia_str_do_processo(so_t *self, int tam, char str[tam],
   // estourou o tamanho de str
   return false;
 }
+// retorna o processo com o pid, pelo espalhamento da tabela (ver tabproc.h)
 pcb *achar_processo(so_t *self, int pid)
 {
-  for (int i = 0; i < MAX_PROCESSES; i++)
-  {
-    if (self->tabela_de_processos[i] != NULL && self->tabela_de_processos[i]->pid == pid)
-    {
-      return self->tabela_de_processos[i];
-    }
-  }
-  return NULL;
+  return tabproc_busca(self->tabela_de_processos, pid);
+}
+
+// retorna o processo corrente (NULL se não tiver)
+static pcb *so_proc_corrente(so_t *self)
+{
+  return tabproc_processo(self->tabela_de_processos, self->processo_corrente);
 }
 // vim: foldmethod=marker
\ No newline at end of file
@@ -15,18 +15,32 @@ typedef struct so_t so_t;
 #include "console.h" // só para uma gambiarra
 #include "metricas.h" // para metricas_t'
 #include "processo.h" // para 'pcb'
+#include "tabproc.h" // para 'tabproc_t'
+#include "bloco.h" // para 'mapa_disco_t'
+#include "programa.h" // para 'programas_t'
+#include "escalonador.h" // para 'escalonador_t'
+// cria o SO, com a política de escalonamento (ver escalonador.h)
 so_t *so_cria(cpu_t *cpu, mem_t *mem, mem_t  *mem_fisica,mmu_t *mmu,
-              es_t *es, console_t *console);
+              es_t *es, console_t *console, esc_politica_t politica);
 void so_destroi(so_t *self);
 
 metricas_t* so_get_metricas(so_t *self);
 es_t* so_get_es(so_t *self);
-pcb** so_get_tabela_de_processos(so_t *self);
+tabproc_t* so_get_tabela_de_processos(so_t *self);
 int so_get_processo_corrente(so_t *self);
 int so_get_intervalo_interrupcao(so_t *self);
 int so_get_algoritmo_substituicao(so_t *self);
+escalonador_t* so_get_escalonador(so_t *self);
+// algoritmos de substituição de páginas (valores de so_get_algoritmo_substituicao)
+#define ALG_FIFO              0
+#define ALG_LRU               1 // aproximação por envelhecimento
+#define ALG_RELOGIO           2 // CLOCK (segunda chance)
+#define ALG_RELOGIO_MELHORADO 3 // CLOCK preferindo páginas não alteradas
 int so_get_tamanho_memoria_fisica(so_t *self);
 int so_get_tamanho_pg(so_t *self);
+mmu_t* so_get_mmu(so_t *self);
+mapa_disco_t* so_get_mapa_disco(so_t *self);
+programas_t* so_get_programas(so_t *self);
 // Chamadas de sistema
 // Uma chamada de sistema é realizada colocando a identificação da
 //   chamada (um dos valores abaixo) no registrador A e executando a
@@ -79,6 +93,13 @@ int so_get_tamanho_pg(so_t *self);
 // retorna em A: 0 se OK ou um código de erro negativo
 #define SO_MATA_PROC   8
 
+// cria um processo que é um clone do chamador: executa o mesmo programa, a
+//   partir da instrução seguinte à chamada, com os mesmos registradores, os
+//   mesmos dispositivos de entrada e saída e uma cópia da memória
+// retorna em A: no processo chamador, o pid do clone, ou código de erro
+//   negativo; no clone, 0
+#define SO_CLONA_PROC 10
+
 // espera um processo terminar
 // recebe em X o pid do processo a esperar
 // retorna em A: 0 se OK ou um código de erro negativo
@@ -86,4 +107,11 @@ int so_get_tamanho_pg(so_t *self);
 // retorna sem bloquear, com erro, se não existir processo com esse pid
 #define SO_ESPERA_PROC 9
 
+// muda o peso do processo chamador na divisão da CPU (só a política cfs
+//   divide a CPU pelo peso; ver esc_cfs.c)
+// recebe em X o peso, de 1 a PESO_MAX (o padrão é PESO_PADRAO, ver processo.h)
+// retorna em A: o peso anterior ou um código de erro negativo
+// os clones começam com o peso de quem os criou
+#define SO_PESO_PROC  11
+
 #endif // SO_H
@@ -7,131 +7,223 @@
 #include <stdlib.h>
 #include <assert.h>
 
-// estrutura auxiliar, contém informação sobre uma página
+// a tabela tem dois níveis: um diretório de ponteiros para folhas, e folhas
+//   com os descritores de PAGINAS_POR_FOLHA páginas consecutivas
+// as folhas são alocadas na primeira vez que uma página delas é mapeada, e
+//   só são liberadas quando a tabela é destruída; o diretório cresce (dobrando)
+//   quando é mapeada uma página além do seu fim, e nunca diminui; assim,
+//   mapear e desmapear páginas não faz alocação nem cópia de memória
+// os bits de validade, acesso, alteração e permissão de uma folha ficam em
+//   mapas de bits, um bit por página
+#define PAGINAS_POR_FOLHA 64
+
 typedef struct {
-  // quadro da memória principal correspondente à página
-  int quadro;
-  // a página está mapeada ou não
-  bool valida;
-  // a página foi acessada ou não
-  bool acessada;
-  // a página foi alterada ou não
-  bool alterada;
-} descritor_t;
+  // quadro da memória principal correspondente a cada página
+  int quadro[PAGINAS_POR_FOLHA];
+  // bits das páginas mapeadas, acessadas e alteradas
+  uint64_t valida;
+  uint64_t acessada;
+  uint64_t alterada;
+  // bits das páginas que podem ser lidas, escritas e executadas
+  uint64_t leitura;
+  uint64_t escrita;
+  uint64_t execucao;
+} folha_t;
 
 struct tabpag_t {
-  // número de descritores na tabela (pode ser 0)
-  int tam_tab;
-  // vetor com os descritores
-  // o último descritor do vetor sempre contém uma página válida
-  // pode ser NULL (se tam_tab == 0)
-  descritor_t *tabela;
+  // número de entradas no diretório (pode ser 0)
+  int n_folhas;
+  // vetor com os ponteiros para as folhas, NULL para folhas não alocadas
+  // pode ser NULL (se n_folhas == 0)
+  folha_t **diretorio;
+  // identificador da tabela, na ordem de criação (ver tabpag_asid)
+  int asid;
 };
 
+// identificador da próxima tabela criada
+static int proximo_asid = 0;
+
 tabpag_t *tabpag_cria(void)
 {
   tabpag_t *self = malloc(sizeof(*self));
   assert(self != NULL);
-  self->tam_tab = 0;
-  self->tabela = NULL;
+  self->n_folhas = 0;
+  self->diretorio = NULL;
+  self->asid = proximo_asid++;
   return self;
 }
 
+int tabpag_asid(tabpag_t *self)
+{
+  return self->asid;
+}
+
 void tabpag_destroi(tabpag_t *self)
 {
   if (self != NULL) {
-    if (self->tabela != NULL) free(self->tabela);
+    for (int i = 0; i < self->n_folhas; i++) {
+      free(self->diretorio[i]);
+    }
+    free(self->diretorio);
     free(self);
   }
 }
 
-// retorna true se a página for válida (pode ser traduzida em um quadro)
-static bool tabpag__pagina_valida(tabpag_t *self, int pagina)
+// retorna a folha que contém a página, ou NULL se não tiver
+static folha_t *tabpag__folha(tabpag_t *self, int pagina)
+{
+  if (pagina < 0) return NULL;
+  int i = pagina / PAGINAS_POR_FOLHA;
+  if (i >= self->n_folhas) return NULL;
+  return self->diretorio[i];
+}
+
+static uint64_t tabpag__bit(int pagina)
 {
-  if (pagina < 0 || pagina >= self->tam_tab) return false;
-  return self->tabela[pagina].valida;
+  return (uint64_t)1 << (pagina % PAGINAS_POR_FOLHA);
+}
+
+// retorna a folha que contém a página, se a página for válida (pode ser
+//   traduzida em um quadro); senão, retorna NULL
+static folha_t *tabpag__folha_valida(tabpag_t *self, int pagina)
+{
+  folha_t *folha = tabpag__folha(self, pagina);
+  if (folha == NULL || !(folha->valida & tabpag__bit(pagina))) return NULL;
+  return folha;
 }
 
 void tabpag_invalida_pagina(tabpag_t *self, int pagina)
 {
-  // página já é inválida -- não faz nada
-  if (!tabpag__pagina_valida(self, pagina)) return;
-  // página não é a última da tabela -- marca como inválida
-  if (pagina < self->tam_tab - 1) {
-    self->tabela[pagina].valida = false;
-    return;
-  }
-  // última página na tabela -- reduz a tabela até que a última seja válida
-  do {
-    self->tam_tab--;
-  } while (self->tam_tab > 0 && !self->tabela[self->tam_tab - 1].valida);
-  if (self->tam_tab == 0) {
-    free(self->tabela);
-    self->tabela = NULL;
-  } else {
-    self->tabela = realloc(self->tabela, self->tam_tab * sizeof(descritor_t));
-    assert(self->tabela != NULL);
-  }
+  folha_t *folha = tabpag__folha(self, pagina);
+  if (folha == NULL) return;
+  folha->valida &= ~tabpag__bit(pagina);
 }
 
-// aumenta a tabela, se necessário, para que contenha 'pagina'
-static void tabpag__insere_pagina(tabpag_t *self, int pagina)
+// aloca, se necessário, a folha que contém 'pagina', e a retorna
+static folha_t *tabpag__insere_pagina(tabpag_t *self, int pagina)
 {
-  if (pagina < self->tam_tab) return;
-  int novo_tam = pagina + 1;
-  if (self->tam_tab == 0) {
-    self->tabela = malloc(novo_tam * sizeof(descritor_t));
-  } else {
-    self->tabela = realloc(self->tabela, novo_tam * sizeof(descritor_t));
+  int i = pagina / PAGINAS_POR_FOLHA;
+  if (i >= self->n_folhas) {
+    int novo_n = self->n_folhas == 0 ? 1 : self->n_folhas;
+    while (novo_n <= i) novo_n *= 2;
+    self->diretorio = realloc(self->diretorio, novo_n * sizeof(folha_t *));
+    assert(self->diretorio != NULL);
+    while (self->n_folhas < novo_n) {
+      self->diretorio[self->n_folhas] = NULL;
+      self->n_folhas++;
+    }
   }
-  assert(self->tabela != NULL);
-  // marca as páginas inseridas como não válidas
-  while (self->tam_tab < novo_tam) {
-    self->tabela[self->tam_tab].valida = false;
-    self->tam_tab++;
+  if (self->diretorio[i] == NULL) {
+    // todas as páginas da folha nova são inválidas
+    self->diretorio[i] = calloc(1, sizeof(folha_t));
+    assert(self->diretorio[i] != NULL);
   }
+  return self->diretorio[i];
 }
 
 void tabpag_define_quadro(tabpag_t *self, int pagina, int quadro)
 {
   assert(pagina >= 0);
-  tabpag__insere_pagina(self, pagina);
-  self->tabela[pagina].quadro = quadro;
-  self->tabela[pagina].valida = true;
-  self->tabela[pagina].acessada = false;
-  self->tabela[pagina].alterada = false;
+  folha_t *folha = tabpag__insere_pagina(self, pagina);
+  uint64_t bit = tabpag__bit(pagina);
+  folha->quadro[pagina % PAGINAS_POR_FOLHA] = quadro;
+  folha->valida |= bit;
+  folha->acessada &= ~bit;
+  folha->alterada &= ~bit;
+  folha->leitura |= bit;
+  folha->escrita |= bit;
+  folha->execucao |= bit;
+}
+
+// liga ou desliga 'bit' em 'mapa'
+static void tabpag__muda_bit(uint64_t *mapa, uint64_t bit, bool liga)
+{
+  if (liga) *mapa |= bit;
+  else *mapa &= ~bit;
+}
+
+void tabpag_define_permissao(tabpag_t *self, int pagina, int permissao)
+{
+  folha_t *folha = tabpag__folha_valida(self, pagina);
+  if (folha == NULL) return;
+  uint64_t bit = tabpag__bit(pagina);
+  tabpag__muda_bit(&folha->leitura, bit, permissao & TABPAG_LEITURA);
+  tabpag__muda_bit(&folha->escrita, bit, permissao & TABPAG_ESCRITA);
+  tabpag__muda_bit(&folha->execucao, bit, permissao & TABPAG_EXECUCAO);
+}
+
+int tabpag_permissao(tabpag_t *self, int pagina)
+{
+  folha_t *folha = tabpag__folha_valida(self, pagina);
+  if (folha == NULL) return 0;
+  uint64_t bit = tabpag__bit(pagina);
+  int permissao = 0;
+  if (folha->leitura & bit) permissao |= TABPAG_LEITURA;
+  if (folha->escrita & bit) permissao |= TABPAG_ESCRITA;
+  if (folha->execucao & bit) permissao |= TABPAG_EXECUCAO;
+  return permissao;
 }
 
 void tabpag_marca_bit_acesso(tabpag_t *self, int pagina, bool alteracao)
 {
-  if (!tabpag__pagina_valida(self, pagina)) return;
-  self->tabela[pagina].acessada = true;
+  folha_t *folha = tabpag__folha_valida(self, pagina);
+  if (folha == NULL) return;
+  folha->acessada |= tabpag__bit(pagina);
   if (alteracao) {
-    self->tabela[pagina].alterada = true;
+    folha->alterada |= tabpag__bit(pagina);
   }
 }
 
 void tabpag_zera_bit_acesso(tabpag_t *self, int pagina)
 {
-  if (!tabpag__pagina_valida(self, pagina)) return;
-  self->tabela[pagina].acessada = false;
+  folha_t *folha = tabpag__folha_valida(self, pagina);
+  if (folha == NULL) return;
+  folha->acessada &= ~tabpag__bit(pagina);
+}
+
+void tabpag_zera_bit_alteracao(tabpag_t *self, int pagina)
+{
+  folha_t *folha = tabpag__folha_valida(self, pagina);
+  if (folha == NULL) return;
+  folha->alterada &= ~tabpag__bit(pagina);
 }
 
 bool tabpag_bit_acesso(tabpag_t *self, int pagina)
 {
-  if (!tabpag__pagina_valida(self, pagina)) return false;
-  return self->tabela[pagina].acessada;
+  folha_t *folha = tabpag__folha_valida(self, pagina);
+  if (folha == NULL) return false;
+  return (folha->acessada & tabpag__bit(pagina)) != 0;
+}
+
+int tabpag_coleta_acessos(tabpag_t *self, uint64_t quadros[])
+{
+  int n = 0;
+  for (int i = 0; i < self->n_folhas; i++) {
+    folha_t *folha = self->diretorio[i];
+    if (folha == NULL) continue;
+    uint64_t acessadas = folha->valida & folha->acessada;
+    folha->acessada &= ~acessadas;
+    while (acessadas != 0) {
+      int quadro = folha->quadro[__builtin_ctzll(acessadas)];
+      quadros[quadro / 64] |= (uint64_t)1 << (quadro % 64);
+      acessadas &= acessadas - 1;
+      n++;
+    }
+  }
+  return n;
 }
 
 bool tabpag_bit_alteracao(tabpag_t *self, int pagina)
 {
-  if (!tabpag__pagina_valida(self, pagina)) return false;
-  return self->tabela[pagina].alterada;
+  folha_t *folha = tabpag__folha_valida(self, pagina);
+  if (folha == NULL) return false;
+  return (folha->alterada & tabpag__bit(pagina)) != 0;
 }
 
 err_t tabpag_traduz(tabpag_t *self, int pagina, int *pquadro)
 {
-  if (!tabpag__pagina_valida(self, pagina)) return ERR_PAG_AUSENTE;
-  *pquadro = self->tabela[pagina].quadro;
+  folha_t *folha = tabpag__folha_valida(self, pagina);
+  if (folha == NULL) return ERR_PAG_AUSENTE;
+  *pquadro = folha->quadro[pagina % PAGINAS_POR_FOLHA];
   return ERR_OK;
 }
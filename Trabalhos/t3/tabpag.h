@@ -10,20 +10,35 @@
 // realiza a tradução de números de páginas do espaço de endereçamento
 //   de um processo em números de quadros da memória principal onde essas
 //   páginas estão mapeadas
-// mantém para cada página mapeada um bit de acesso e um bit de alteração
+// mantém para cada página mapeada um bit de acesso e um bit de alteração,
+//   e as permissões de acesso à página (leitura, escrita, execução)
 
 #include "err.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 // tipo opaco que representa a tabela de páginas
 typedef struct tabpag_t tabpag_t;
 
+// permissões de acesso a uma página, que podem ser combinadas com '|'
+#define TABPAG_LEITURA  1
+#define TABPAG_ESCRITA  2
+#define TABPAG_EXECUCAO 4
+#define TABPAG_TODAS    (TABPAG_LEITURA | TABPAG_ESCRITA | TABPAG_EXECUCAO)
+
 // cria uma tabela de páginas
 // retorna um ponteiro para um descritor, que deverá ser usado em todas
 //   as operações nessa tabela
 // mata o programa em caso de erro (malloc)
 tabpag_t *tabpag_cria(void);
 
+// retorna o identificador da tabela (address space id), um número diferente
+//   para cada tabela, na ordem em que foram criadas
+// não depende do endereço da tabela na memória do simulador, então pode ser
+//   usado onde o resultado deve ser o mesmo em todas as execuções (ver a TLB,
+//   em mmu.c)
+int tabpag_asid(tabpag_t *self);
+
 // destrói uma tabela de páginas
 // libera a memória ocupara pela tabela
 // nenhuma outra operação pode ser realizada na tabela após esta chamada
@@ -31,10 +46,18 @@ void tabpag_destroi(tabpag_t *self);
 
 // define que a tradução da página 'pagina' deve resultar no quadro 'quadro'
 // essa página é marcada como válida, e os bits de acesso e alteração para essa
-//   página são zerados
+//   página são zerados; a página tem todas as permissões (TABPAG_TODAS)
 // páginas sem quadro definido são consideradas inválidas
 void tabpag_define_quadro(tabpag_t *self, int pagina, int quadro);
 
+// define as permissões de acesso à página 'pagina' (TABPAG_LEITURA etc)
+// não faz nada se a página for inválida
+void tabpag_define_permissao(tabpag_t *self, int pagina, int permissao);
+
+// retorna as permissões de acesso à página
+// retorna 0 (nenhuma permissão) se a página for inválida
+int tabpag_permissao(tabpag_t *self, int pagina);
+
 // marca a página 'pagina' como inválida.
 // as informações sobre essa página são perdidas.
 void tabpag_invalida_pagina(tabpag_t *self, int pagina);
@@ -48,10 +71,20 @@ void tabpag_marca_bit_acesso(tabpag_t *self, int pagina, bool alteracao);
 // não faz nada se a página for inválida
 void tabpag_zera_bit_acesso(tabpag_t *self, int pagina);
 
+// zera o bit de alteração da página (quando o conteúdo foi gravado no disco)
+// não faz nada se a página for inválida
+void tabpag_zera_bit_alteracao(tabpag_t *self, int pagina);
+
 // retorna o valor do bit de acesso à página
 // retorna false se a página for inválida
 bool tabpag_bit_acesso(tabpag_t *self, int pagina);
 
+// zera os bits de acesso de todas as páginas; para cada página que tinha
+//   sido acessada, liga o bit do seu quadro no mapa de bits 'quadros'
+//   (64 quadros por palavra)
+// retorna o número de páginas que tinham sido acessadas
+int tabpag_coleta_acessos(tabpag_t *self, uint64_t quadros[]);
+
 // retorna o valor do bit de alteração da página
 // retorna false se a página for inválida
 bool tabpag_bit_alteracao(tabpag_t *self, int pagina);
@@ -0,0 +1,142 @@
+// tabproc.c
+// tabela de processos
+// simulador de computador
+// so25b
+
+#include "tabproc.h"
+#include "processo.h"
+#include <stdlib.h>
+#include <assert.h>
+
+struct tabproc_t {
+  int tamanho;      // número de posições
+  int tam_max;      // até onde a tabela pode crescer
+  pcb **processos;  // processo em cada posição (NULL se livre)
+  int *livres;      // pilha das posições livres
+  int n_livres;
+  pcb **listas;     // listas do espalhamento pelo pid, uma por posição
+  int max_num;      // maior número de processos ao mesmo tempo
+};
+
+// a lista de um pid; os pids são consecutivos, então o resto da divisão
+//   espalha bem
+static pcb **tabproc__lista(tabproc_t *self, int pid)
+{
+  return &self->listas[(unsigned)pid % self->tamanho];
+}
+
+static void tabproc__espalha(tabproc_t *self, pcb *proc)
+{
+  pcb **lista = tabproc__lista(self, proc->pid);
+  proc->prox_hash = *lista;
+  *lista = proc;
+}
+
+// aumenta a tabela para 'tamanho' posições; as novas ficam livres (as de
+//   menor índice no topo da pilha) e os processos são espalhados de novo
+static void tabproc__cresce(tabproc_t *self, int tamanho)
+{
+  int antigo = self->tamanho;
+  self->processos = realloc(self->processos, tamanho * sizeof(*self->processos));
+  self->livres = realloc(self->livres, tamanho * sizeof(*self->livres));
+  free(self->listas);
+  self->listas = calloc(tamanho, sizeof(*self->listas));
+  assert(self->processos != NULL && self->livres != NULL && self->listas != NULL);
+  self->tamanho = tamanho;
+  for (int i = tamanho - 1; i >= antigo; i--) {
+    self->processos[i] = NULL;
+    self->livres[self->n_livres++] = i;
+  }
+  for (int i = 0; i < antigo; i++) {
+    if (self->processos[i] != NULL) tabproc__espalha(self, self->processos[i]);
+  }
+}
+
+tabproc_t *tabproc_cria(int tam_inicial, int tam_max)
+{
+  assert(tam_inicial > 0 && tam_inicial <= tam_max);
+  tabproc_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->tamanho = 0;
+  self->tam_max = tam_max;
+  self->processos = NULL;
+  self->livres = NULL;
+  self->n_livres = 0;
+  self->listas = NULL;
+  self->max_num = 0;
+  tabproc__cresce(self, tam_inicial);
+  return self;
+}
+
+void tabproc_destroi(tabproc_t *self)
+{
+  if (self == NULL) return;
+  free(self->processos);
+  free(self->livres);
+  free(self->listas);
+  free(self);
+}
+
+int tabproc_insere(tabproc_t *self, pcb *proc)
+{
+  if (self->n_livres == 0) {
+    if (self->tamanho >= self->tam_max) return -1;
+    int tamanho = self->tamanho * 2;
+    if (tamanho > self->tam_max) tamanho = self->tam_max;
+    tabproc__cresce(self, tamanho);
+  }
+  int indice = self->livres[--self->n_livres];
+  self->processos[indice] = proc;
+  proc->indice = indice;
+  tabproc__espalha(self, proc);
+  int num = tabproc_num(self);
+  if (num > self->max_num) self->max_num = num;
+  return indice;
+}
+
+void tabproc_remove(tabproc_t *self, pcb *proc)
+{
+  int indice = proc->indice;
+  if (indice < 0 || indice >= self->tamanho || self->processos[indice] != proc) return;
+  pcb **p = tabproc__lista(self, proc->pid);
+  while (*p != proc) p = &(*p)->prox_hash;
+  *p = proc->prox_hash;
+  proc->prox_hash = NULL;
+  self->processos[indice] = NULL;
+  self->livres[self->n_livres++] = indice;
+  proc->indice = -1;
+}
+
+bool tabproc_cheia(tabproc_t *self)
+{
+  return self->n_livres == 0 && self->tamanho >= self->tam_max;
+}
+
+pcb *tabproc_processo(tabproc_t *self, int indice)
+{
+  if (indice < 0 || indice >= self->tamanho) return NULL;
+  return self->processos[indice];
+}
+
+pcb *tabproc_busca(tabproc_t *self, int pid)
+{
+  for (pcb *p = *tabproc__lista(self, pid); p != NULL; p = p->prox_hash) {
+    if (p->pid == pid) return p;
+  }
+  return NULL;
+}
+
+int tabproc_tamanho(tabproc_t *self)
+{
+  return self->tamanho;
+}
+
+int tabproc_num(tabproc_t *self)
+{
+  return self->tamanho - self->n_livres;
+}
+
+int tabproc_max_num(tabproc_t *self)
+{
+  return self->max_num;
+}
@@ -0,0 +1,51 @@
+// tabproc.h
+// tabela de processos
+// simulador de computador
+// so25b
+
+#ifndef TABPROC_H
+#define TABPROC_H
+
+// a tabela guarda os processos que existem, cada um em uma posição (índice)
+//   que não muda enquanto ele está na tabela; o SO identifica o processo
+//   corrente pela posição
+// a tabela começa pequena e dobra de tamanho quando fica cheia, até um
+//   tamanho máximo. As posições livres ficam em uma pilha, e a busca pelo pid
+//   usa uma tabela de espalhamento encadeada pelos próprios PCBs (campo
+//   prox_hash), com tantas listas quanto posições: inserir, remover e buscar
+//   um processo custam O(1), e nada percorre a tabela inteira
+
+#include <stdbool.h>
+
+struct pcb;
+
+typedef struct tabproc_t tabproc_t;
+
+// cria uma tabela vazia, com 'tam_inicial' posições, que pode crescer até
+//   'tam_max'
+tabproc_t *tabproc_cria(int tam_inicial, int tam_max);
+// destrói a tabela (os processos que estão nela não são destruídos)
+void tabproc_destroi(tabproc_t *self);
+
+// coloca o processo em uma posição livre, aumentando a tabela se necessário
+// retorna a posição (também colocada em proc->indice), ou -1 se a tabela
+//   está cheia e não pode mais crescer
+int tabproc_insere(tabproc_t *self, struct pcb *proc);
+// tira o processo da tabela; a posição dele fica livre
+void tabproc_remove(tabproc_t *self, struct pcb *proc);
+
+// retorna true se não cabe mais nenhum processo na tabela
+bool tabproc_cheia(tabproc_t *self);
+
+// retorna o processo na posição 'indice' (NULL se livre ou fora da tabela)
+struct pcb *tabproc_processo(tabproc_t *self, int indice);
+// retorna o processo com o pid, ou NULL se não estiver na tabela
+struct pcb *tabproc_busca(tabproc_t *self, int pid);
+
+// número de posições da tabela (as posições vão de 0 a tamanho-1)
+int tabproc_tamanho(tabproc_t *self);
+// número de processos na tabela, e o maior que já esteve nela
+int tabproc_num(tabproc_t *self);
+int tabproc_max_num(tabproc_t *self);
+
+#endif // TABPROC_H
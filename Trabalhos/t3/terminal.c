@@ -33,6 +33,8 @@ struct terminal_t {
   enum { normal, rolando, limpando } estado_saida;
   // posicao do caractere que está sendo movido durante uma rolagem
   int pos_rolagem;
+  // se não for NULL, recebe uma cópia de tudo que é impresso na saída
+  FILE *arquivo_saida;
 };
 
 
@@ -48,6 +50,7 @@ terminal_t *terminal_cria(int tam_linha)
   assert(self->saida != NULL && self->entrada != NULL);
 
   self->estado_saida = normal;
+  self->arquivo_saida = NULL;
 
   return self;
 }
@@ -92,6 +95,10 @@ static err_t terminal_imprime(terminal_t *self, char ch)
 {
   if (!terminal_pode_imprimir(self)) return ERR_OCUP;
 
+  if (self->arquivo_saida != NULL) {
+    fputc(ch, self->arquivo_saida);
+  }
+
   if (ch == '\n') {
     // se for impresso \n, inicia a limpeza da linha
     self->estado_saida = limpando;
@@ -110,6 +117,11 @@ static err_t terminal_imprime(terminal_t *self, char ch)
   return ERR_OK;
 }
 
+void terminal_define_arquivo_saida(terminal_t *self, FILE *arq)
+{
+  self->arquivo_saida = arq;
+}
+
 void terminal_limpa_saida(terminal_t *self)
 {
   self->saida[0] = '\0';
@@ -148,6 +160,11 @@ void terminal_tictac(terminal_t *self)
   terminal_atualiza_limpeza(self);
 }
 
+bool terminal_ocioso(terminal_t *self)
+{
+  return self->estado_saida == normal;
+}
+
 char *terminal_txt_entrada(terminal_t *self)
 {
   return self->entrada;
@@ -34,6 +34,7 @@
 //   linha de saída com terminal_limpa_saida.
 
 #include <stdbool.h>
+#include <stdio.h>
 #include "err.h"
 
 typedef struct terminal_t terminal_t;
@@ -62,9 +63,19 @@ void terminal_insere_char(terminal_t *self, char ch);
 // limpa a linha de saída (para uso pela console)
 void terminal_limpa_saida(terminal_t *self);
 
+// define um arquivo onde é gravada uma cópia de cada caractere impresso na
+//   saída do terminal (para uso pela console, quando executa sem tela)
+// o arquivo não pertence ao terminal, não é fechado por ele
+// se 'arq' for NULL, não grava a saída em arquivo
+void terminal_define_arquivo_saida(terminal_t *self, FILE *arq);
+
 // esta função deve ser chamada periodicamente
 void terminal_tictac(terminal_t *self);
 
+// retorna true se a saída não estiver rolando nem sendo limpa (nesse caso,
+//   terminal_tictac não altera o terminal)
+bool terminal_ocioso(terminal_t *self);
+
 // Funções para implementar o protocolo de acesso a um dispositivo pelo
 //   controlador de E/S
 // Devem seguir o protocolo f_leitura_t e f_escrita_t declarados em es.h